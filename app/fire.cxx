@@ -8,11 +8,13 @@
 #include <unistd.h>
 
 #include <iostream>
+#include <string>
 
 //-------------//
 //   ldmx-sw   //
 //-------------//
 #include "Framework/ConfigurePython.h"
+#include "Framework/PluginFactory.h"
 #include "Framework/Process.h"
 
 /**
@@ -54,8 +56,30 @@ int main(int argc, char* argv[]) try {
     return 1;
   }
 
+  if (strcmp(argv[1], "--make-plugin-index") == 0) {
+    if (argc < 3) {
+      printUsage();
+      return 1;
+    }
+    auto& factory{framework::PluginFactory::getInstance()};
+    try {
+      for (int i = 3; i < argc; i++) factory.loadLibrary(argv[i]);
+      factory.writeIndex(argv[2]);
+    } catch (const framework::exception::Exception& e) {
+      std::cerr << "Plugin Index Error [" << e.name() << "] : " << e.message()
+                << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  std::string cache_file;
   int ptrpy = 1;
   for (ptrpy = 1; ptrpy < argc; ptrpy++) {
+    if (strcmp(argv[ptrpy], "--config-cache") == 0 and ptrpy + 1 < argc) {
+      cache_file = argv[++ptrpy];
+      continue;
+    }
     if (strstr(argv[ptrpy], ".py")) break;
   }
 
@@ -72,7 +96,7 @@ int main(int argc, char* argv[]) try {
   framework::ProcessHandle p;
   try {
     framework::ConfigurePython cfg(argv[ptrpy], argv + ptrpy + 1,
-                                   argc - ptrpy - 1);
+                                   argc - ptrpy - 1, cache_file);
     p = cfg.makeProcess();
   } catch (const framework::exception::Exception& e) {
     // Error message currently printed twice since the stack trace code
@@ -133,8 +157,17 @@ int main(int argc, char* argv[]) try {
 }
 
 void printUsage() {
-  std::cout << "Usage: fire {configuration_script.py} [arguments to "
-               "configuration script]"
+  std::cout << "Usage: fire [--config-cache {file}] "
+               "{configuration_script.py} [arguments to configuration script]"
+            << std::endl;
+  std::cout << "       fire --make-plugin-index {index} [libraries]"
+            << std::endl;
+  std::cout << "     --make-plugin-index      write which of the libraries "
+               "each processor and conditions provider is in to the index"
+            << std::endl;
+  std::cout << "     --config-cache file      (optional) reuse the "
+               "configuration stored in file if it came from the same script "
+               "and arguments, otherwise store it there"
             << std::endl;
   std::cout << "     configuration_script.py  (required) python script to "
                "configure the processing"
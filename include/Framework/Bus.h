@@ -6,10 +6,12 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 // ROOT
 #include "TBranchElement.h"
+#include "TDictionary.h"
 #include "TTree.h"
 
 namespace framework {
@@ -63,6 +65,16 @@ class Bus {
    */
   template <typename BaggageType>
   void board(const std::string& name) {
+    auto parked{parked_.find(name)};
+    if (parked != parked_.end()) {
+      // a passenger carrying the same type is waiting from the last file,
+      //  reuse it (and the memory its baggage already holds)
+      bool same_type{dynamic_cast<Passenger<BaggageType>*>(
+                         parked->second.get()) != nullptr};
+      if (same_type) passengers_[name] = std::move(parked->second);
+      parked_.erase(parked);
+      if (same_type) return;
+    }
     passengers_[name] = std::make_unique<Passenger<BaggageType>>();
     passengers_[name]->clear();  // make sure 'default' state is well defined
   }
@@ -108,6 +120,33 @@ class Bus {
     return passengers_[name]->attach(tree, name, can_create);
   }
 
+  /**
+   * Get the address of the object a passenger is carrying
+   *
+   * This is used to connect the baggage to storage backends
+   * which do not know the type of the object at compile time.
+   *
+   * @note Does not check if passenger exists in the map of passengers.
+   *
+   * @param[in] name name of passenger
+   * @returns pointer to the baggage of the passenger
+   */
+  void* address(const std::string& name) {
+    return passengers_[name]->address();
+  }
+
+  /**
+   * Get the name of the type of object a passenger is carrying
+   *
+   * @note Does not check if passenger exists in the map of passengers.
+   *
+   * @param[in] name name of passenger
+   * @returns ROOT name of the type of the baggage
+   */
+  std::string typeName(const std::string& name) {
+    return passengers_[name]->typeName();
+  }
+
   /**
    * Check if a passenger is on the bus
    *
@@ -118,6 +157,43 @@ class Bus {
     return passengers_.find(name) != passengers_.end();
   }
 
+  /**
+   * Kick a single passenger off the bus, destroying its baggage
+   *
+   * This is used to undo boarding a passenger that could not be
+   * attached to its input branch.
+   *
+   * @param[in] name name of passenger to kick off
+   */
+  void getOff(const std::string& name) { passengers_.erase(name); }
+
+  /**
+   * Board a new passenger carrying the same type as a passenger
+   * on another bus
+   *
+   * @note Does not check if the passenger is on the other bus.
+   *
+   * @param[in] name name of passenger on both buses
+   * @param[in] other bus with passenger to copy the type from
+   */
+  void boardLike(const std::string& name, const Bus& other) {
+    passengers_[name] = other.passengers_.at(name)->emptyCopy();
+  }
+
+  /**
+   * Exchange the baggage of a passenger with the passenger of
+   * the same name on another bus
+   *
+   * @see Passenger::exchange for how the baggage is exchanged
+   * @throws std::bad_cast if the passengers carry different types
+   *
+   * @param[in] name name of passenger on both buses
+   * @param[in,out] other bus to exchange baggage with
+   */
+  void exchange(const std::string& name, Bus& other) {
+    passengers_.at(name)->exchange(*other.passengers_.at(name));
+  }
+
   /**
    * Reset the objects carried by the passengers
    *
@@ -137,7 +213,37 @@ class Bus {
    * @see Bus::Passenger::~Passenger for comments
    * about why you need to be careful.
    */
-  void everybodyOff() { passengers_.clear(); }
+  void everybodyOff() {
+    passengers_.clear();
+    parked_.clear();
+  }
+
+  /**
+   * Move all of the passengers off the bus without destroying them
+   *
+   * This is used instead of everybodyOff between files. The passengers
+   * keep their (cleared) baggage and board again when an object of the
+   * same name and type is needed in the next file, so buffers like the
+   * capacity of large vectors are kept as long as the files have the
+   * same content. Passengers that were parked before the last file
+   * and didn't board again during it are dropped, so switching between
+   * files with different content doesn't keep adding passengers.
+   *
+   * Parking an empty bus does nothing, so this can be called more
+   * than once between files.
+   *
+   * @note The passengers need to be detached from any trees they
+   * were attached to before parking them.
+   */
+  void parkEverybody() {
+    if (passengers_.empty()) return;
+    parked_.clear();
+    for (auto& [n, handle] : passengers_) {
+      handle->clear();
+      parked_[n] = std::move(handle);
+    }
+    passengers_.clear();
+  }
 
   /**
    * Write the bus to the input ostream.
@@ -222,6 +328,38 @@ class Bus {
      */
     virtual void stream(std::ostream& s) const = 0;
 
+    /**
+     * Get the address of the object this passenger is carrying
+     *
+     * @returns type-less pointer to the baggage
+     */
+    virtual void* address() = 0;
+
+    /**
+     * Get the name of the type of object this passenger is carrying
+     *
+     * @returns name of the type of the baggage
+     */
+    virtual std::string typeName() const = 0;
+
+    /**
+     * Create a new passenger carrying an empty object of the same type
+     *
+     * @returns seat of the new passenger
+     */
+    virtual std::unique_ptr<Seat> emptyCopy() const = 0;
+
+    /**
+     * Exchange the objects carried by this and another passenger
+     *
+     * The objects are swapped in place, so any trees attached
+     * to either passenger still point to the right place.
+     *
+     * @throws std::bad_cast if the other passenger carries another type
+     * @param[in,out] other passenger to exchange baggage with
+     */
+    virtual void exchange(Seat& other) = 0;
+
     /**
      * Stream this object to the output stream
      *
@@ -387,6 +525,51 @@ class Bus {
       stream(the_type<BaggageType>{}, s);
     }
 
+    /**
+     * Get the address of our baggage
+     *
+     * @returns type-less pointer to our baggage
+     */
+    virtual void* address() { return baggage_; }
+
+    /**
+     * Get the name of the type of our baggage
+     *
+     * We ask ROOT for the name so that it matches the name used
+     * in the dictionary (e.g. "int" or "vector<ldmx::EcalHit>"),
+     * falling back to the compiler-level type name if ROOT
+     * doesn't know about our type.
+     *
+     * @returns name of the type of our baggage
+     */
+    virtual std::string typeName() const {
+      TDictionary* dict = TDictionary::GetDictionary(typeid(BaggageType));
+      if (dict) return dict->GetName();
+      return typeid(BaggageType).name();
+    }
+
+    /**
+     * Create a new passenger carrying an empty object of our type
+     *
+     * @returns seat of the new passenger
+     */
+    virtual std::unique_ptr<Seat> emptyCopy() const {
+      auto seat{std::make_unique<Passenger<BaggageType>>()};
+      seat->clear();
+      return seat;
+    }
+
+    /**
+     * Swap our baggage with the baggage of another passenger
+     *
+     * @throws std::bad_cast if the other passenger carries another type
+     * @param[in,out] other passenger to exchange baggage with
+     */
+    virtual void exchange(Seat& other) {
+      std::swap(*baggage_,
+                *dynamic_cast<Passenger<BaggageType>&>(other).baggage_);
+    }
+
     /**
      * Stream this object to the output stream
      *
@@ -820,6 +1003,13 @@ class Bus {
    */
   std::unordered_map<std::string, std::unique_ptr<Seat>> passengers_;
 
+  /**
+   * Passengers waiting to board again in the next file
+   *
+   * @see parkEverybody
+   */
+  std::unordered_map<std::string, std::unique_ptr<Seat>> parked_;
+
 };  // Bus
 
 }  // namespace framework
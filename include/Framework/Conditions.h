@@ -16,6 +16,7 @@
 /*~~~~~~~~~~~~~~~*/
 /*   Framework   */
 /*~~~~~~~~~~~~~~~*/
+#include "Framework/ConditionsDiskCache.h"
 #include "Framework/ConditionsIOV.h"
 #include "Framework/Configure/Parameters.h"
 #include "Framework/Logger.h"
@@ -24,7 +25,13 @@
 /*   C++ StdLib   */
 /*~~~~~~~~~~~~~~~~*/
 #include <any>
+#include <atomic>
+#include <cstdint>
+#include <future>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace ldmx {
 class RunHeader;
@@ -39,6 +46,17 @@ class ConditionsObject;
 /**
  * @class Conditions
  * @brief Container and cache for conditions and conditions providers
+ *
+ * Several versions (with different IOVs) of each condition can be kept
+ * in the cache so that switching back and forth between runs does not
+ * require reloading the conditions each time. The version used by an
+ * event is pinned until the thread that requested it calls onEndOfEvent,
+ * versions beyond the cache depth are released once nothing pins them.
+ *
+ * Requesting a condition that is already loaded and valid for the
+ * current event does not take any locks, so conditions can be requested
+ * from more than one thread. Loading a new version from a provider is
+ * serialized for each condition.
  */
 class Conditions {
  public:
@@ -49,8 +67,67 @@ class Conditions {
 
   /**
    * Class destructor.
+   *
+   * Waits for a prefetch that is still running.
+   */
+  ~Conditions();
+
+  /**
+   * Set the maximum number of versions of each condition to keep
+   *
+   * Versions that are still used by an event are kept even if
+   * there are more of them than this.
+   *
+   * @throws Exception if the depth is less than one
+   *
+   * @param[in] depth maximum number of versions to keep for each condition
+   */
+  void setCacheDepth(int depth);
+
+  /**
+   * Share conditions objects with other jobs through a cache on disk
+   *
+   * Objects are read from the cache instead of being loaded by their
+   * provider if they are in the cache, otherwise they are put into the
+   * cache after being loaded.
+   *
+   * @see ConditionsDiskCache
+   * @param[in] directory directory to keep the cache in
+   */
+  void setDiskCache(const std::string& directory);
+
+  /**
+   * Turn on prefetching the conditions for the next run in the background
+   *
+   * Only providers that can provide their conditions for a run
+   * before their onNewRun callback has been called for it should
+   * be used with this. The cache needs to be at least two deep
+   * to keep the prefetched versions around.
+   *
+   * @param[in] prefetch true if prefetch should load the next run
+   */
+  void setPrefetchNextRun(bool prefetch) { prefetchNextRun_ = prefetch; }
+
+  /**
+   * Declare that a condition is needed for processing every run
+   *
+   * Required conditions are loaded in onNewRun so that the loading
+   * isn't done in the middle of processing the first event of a run.
+   *
+   * @param[in] condition_name name of condition that is needed
+   */
+  void require(const std::string& condition_name);
+
+  /**
+   * Start loading the required conditions for an upcoming run
+   *
+   * The conditions are loaded in the background, the next onNewRun
+   * waits for the loading to be done. Does nothing unless prefetching
+   * of the next run was turned on.
+   *
+   * @param[in] run run number of the upcoming run
    */
-  ~Conditions() { ; }
+  void prefetch(int run);
 
   /**
    * Primary request action for a conditions object If the
@@ -84,6 +161,24 @@ class Conditions {
     return dynamic_cast<const T&>(*getConditionPtr(condition_name));
   }
 
+  /**
+   * Get the current generation of the conditions
+   *
+   * The generation changes whenever the conditions returned for
+   * an event could be different from the ones returned before,
+   * i.e. when a new run starts or when a different version of
+   * a condition is loaded. Nothing changes while it stays the same.
+   *
+   * @returns current generation counter
+   */
+  std::uint64_t generation() const { return generation_.load(); }
+
+  /**
+   * Start a new generation, forcing ConditionHandles to look up
+   * their conditions again
+   */
+  void invalidate() { generation_++; }
+
   /**
    * Access the IOV for the given condition
    *
@@ -92,8 +187,37 @@ class Conditions {
    */
   ConditionsIOV getConditionIOV(const std::string& condition_name) const;
 
+  /**
+   * Release the conditions requested by this thread for the current event
+   *
+   * The objects returned by getConditionPtr on this thread should not be
+   * used after calling this.
+   */
+  void onEndOfEvent() { releaseSince(0); }
+
+  /**
+   * Mark the conditions requested by this thread so far
+   *
+   * @see releaseSince
+   * @returns mark to pass to releaseSince
+   */
+  std::size_t pinMark() const { return pinned_.size(); }
+
+  /**
+   * Release the conditions requested by this thread after a mark
+   *
+   * This is used when a thread runs a processor while another
+   * processor it was already running waits, so that only the
+   * conditions of the inner processor are released.
+   *
+   * @param[in] mark value returned by pinMark before the inner processor
+   */
+  void releaseSince(std::size_t mark);
+
   /**
    * Calls onProcessStart for all ConditionsObjectProviders
+   *
+   * @throws Exception if a required condition has no provider
    */
   void onProcessStart();
 
@@ -103,7 +227,8 @@ class Conditions {
   void onProcessEnd();
 
   /**
-   * Calls onNewRun for all ConditionsObjectProviders
+   * Calls onNewRun for all ConditionsObjectProviders and then
+   * loads all of the required conditions
    */
   void onNewRun(ldmx::RunHeader&);
 
@@ -121,20 +246,222 @@ class Conditions {
   /** Map of who provides which condition */
   std::map<std::string, ConditionsObjectProvider*> providerMap_;
 
+  struct Slot;
+
   /**
    * An entry to store an already loaded conditions object
+   *
+   * Entries are never deleted while the cache exists, they are reused
+   * for new versions once their object has been released. This is what
+   * allows a reader to pin an entry without holding the slot's lock.
    */
   struct CacheEntry {
     /// Interval Of Validity for this entry in the cache
     ConditionsIOV iov;
-    /// Provider that gave us the conditions object
-    ConditionsObjectProvider* provider;
-    /// Const pointer to the retrieved conditions object
-    const ConditionsObject* obj;
+    /// Const pointer to the retrieved conditions object, nullptr if unused
+    const ConditionsObject* obj{nullptr};
+    /// Slot this entry belongs to
+    Slot* slot{nullptr};
+    /// Number of in-flight events using this entry
+    std::atomic<int> pins{0};
+    /// Release the object once it isn't pinned anymore
+    std::atomic<bool> retired{false};
+    /// Bits of the threads (see threadBit) with this entry in pinned_
+    std::atomic<std::uint64_t> pinnedBy{0};
+    /// When this entry was last made current, for choosing what to evict
+    std::uint64_t lastCurrent{0};
+  };
+
+  /**
+   * All of the cached versions of one condition
+   */
+  struct Slot {
+    /// Provider that gives us the conditions objects
+    ConditionsObjectProvider* provider{nullptr};
+    /// Entry that was most recently loaded or used after a miss
+    std::atomic<CacheEntry*> current{nullptr};
+    /// Lock for loading and evicting entries
+    mutable std::mutex mutex;
+    /// All of the entries, in use or not
+    std::vector<std::unique_ptr<CacheEntry>> entries;
+    /// Number of times an entry was made current
+    std::uint64_t counter{0};
   };
 
-  /** Conditions cache */
-  std::map<std::string, CacheEntry> cache_;
+  /**
+   * Find or load the version of a condition valid for the input event
+   *
+   * This is the slow path of getConditionPtr, it locks the slot.
+   *
+   * @param[in] slot slot of the condition to load
+   * @param[in] name name of the condition, for error messages
+   * @param[in] context header of event the condition is for
+   * @param[in] make_current use the version for events without checking
+   * @returns pinned entry with the valid version
+   */
+  CacheEntry* load(Slot& slot, const std::string& name,
+                   const ldmx::EventHeader& context, bool make_current = true);
+
+  /**
+   * Wait for the prefetch to finish, warning if it failed
+   */
+  void waitForPrefetch();
+
+  /**
+   * Retire versions of a condition until there are no more than the depth
+   *
+   * The slot must be locked by the caller.
+   *
+   * @param[in] slot slot to trim
+   */
+  void trim(Slot& slot);
+
+  /**
+   * Give the object in an entry back to its provider
+   *
+   * The slot of the entry must be locked by the caller.
+   *
+   * @param[in] entry entry to release
+   */
+  static void release(CacheEntry& entry);
+
+  /**
+   * Pin the entry for the current event on this thread
+   *
+   * @param[in] entry entry to pin
+   */
+  static void pin(CacheEntry* entry);
+
+  /**
+   * Remove a pin from the entry, releasing it if it is retired
+   *
+   * @param[in] entry entry to unpin
+   */
+  static void unpin(CacheEntry* entry);
+
+  /**
+   * Get the bit marking the entries pinned by this thread
+   *
+   * The first 64 threads to pin an entry get a bit of their own,
+   * the others get zero and have to search their pinned_ list.
+   *
+   * @returns bit of this thread in CacheEntry::pinnedBy, or zero
+   */
+  static std::uint64_t threadBit();
+
+  /**
+   * Check if the entry is pinned by this thread
+   *
+   * @param[in] entry entry to check
+   * @returns true if the entry is in pinned_
+   */
+  static bool isPinned(const CacheEntry* entry);
+
+  /**
+   * Add an entry that has already been pinned to pinned_
+   *
+   * @param[in] entry pinned entry
+   */
+  static void track(CacheEntry* entry);
+
+  /// Maximum number of versions to keep for each condition
+  std::size_t cacheDepth_{2};
+
+  /// Cache of conditions objects shared between jobs, if used
+  std::unique_ptr<ConditionsDiskCache> diskCache_;
+
+  /// Names of the conditions loaded at the start of each run
+  std::vector<std::string> required_;
+
+  /// Should we prefetch the conditions for the next run?
+  bool prefetchNextRun_{false};
+
+  /// The background prefetch of the next run
+  std::future<void> prefetch_;
+
+  /// Generation counter, zero is never used so handles start invalid
+  std::atomic<std::uint64_t> generation_{1};
+
+  /** Conditions cache, the map is only modified during configuration */
+  std::map<std::string, Slot> slots_;
+
+  /// Entries pinned by this thread for the event it is working on
+  static thread_local std::vector<CacheEntry*> pinned_;
+
+  /// Event to load conditions for on this thread, the process's if nullptr
+  static thread_local const ldmx::EventHeader* context_;
+
+  /// The logger for the conditions system
+  enableLogging("Conditions")
+};
+
+/**
+ * @class ConditionHandle
+ * @brief Cached access to a conditions object
+ *
+ * Getting a condition by name looks it up in the cache and checks
+ * its IOV on every call. A handle remembers the object it got the
+ * last time along with the generation of the conditions, so getting
+ * the object again only requires comparing the generation until
+ * the run changes or a new version of a condition is loaded.
+ *
+ * Handles should be created once (e.g. in configure) and used by
+ * the processor that created them.
+ *
+ * @tparam T type of conditions object
+ */
+template <class T>
+class ConditionHandle {
+ public:
+  /**
+   * Create a handle for the input condition
+   *
+   * The condition isn't looked up until it is first used.
+   *
+   * @param[in] conditions the conditions system
+   * @param[in] condition_name name of the condition
+   */
+  ConditionHandle(Conditions& conditions, const std::string& condition_name)
+      : conditions_{&conditions}, name_{condition_name} {}
+
+  /// Default constructor for handles assigned later
+  ConditionHandle() = default;
+
+  /**
+   * Get the conditions object for the current event
+   *
+   * @returns const reference to conditions object
+   */
+  const T& get() {
+    std::uint64_t generation{conditions_->generation()};
+    if (generation != generation_) {
+      object_ = &conditions_->getCondition<T>(name_);
+      generation_ = generation;
+    }
+    return *object_;
+  }
+
+  /// @see get
+  const T& operator*() { return get(); }
+
+  /// @see get
+  const T* operator->() { return &get(); }
+
+  /// @returns name of the condition
+  const std::string& name() const { return name_; }
+
+ private:
+  /// the conditions system
+  Conditions* conditions_{nullptr};
+
+  /// name of the condition
+  std::string name_;
+
+  /// object from the last lookup
+  const T* object_{nullptr};
+
+  /// generation of the last lookup, zero if it hasn't been looked up
+  std::uint64_t generation_{0};
 };
 
 }  // namespace framework
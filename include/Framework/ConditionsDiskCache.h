@@ -0,0 +1,123 @@
+#ifndef FRAMEWORK_CONDITIONSDISKCACHE_H_
+#define FRAMEWORK_CONDITIONSDISKCACHE_H_
+
+//---< C++ >---//
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+//---< Framework >---//
+#include "Framework/ConditionsIOV.h"
+#include "Framework/Logger.h"
+
+namespace ldmx {
+class EventHeader;
+}
+
+namespace framework {
+
+class ConditionsObject;
+class ConditionsObjectProvider;
+
+/**
+ * A local, on-disk cache of serialized conditions objects
+ *
+ * Many jobs starting at the same time on one node would all ask the
+ * same conditions sources for the same objects. Instead, the first job
+ * to load an object writes it into this cache and the other jobs read
+ * it from there. The cache files are only ever replaced as a whole
+ * (by renaming a complete file into place) so that any number of jobs
+ * can read and write the cache at the same time.
+ *
+ * Each object is stored in its own file
+ *
+ *    <directory>/<object name>/<tag>/<parameters>/
+ *        <first run>_<last run>_<data><mc>.cond
+ *
+ * where parameters is the hash of the parameters of the provider (which
+ * include its class name) and data and mc are 1 or 0 depending on if
+ * the IOV is valid for real data or simulation. Jobs sharing the cache
+ * only share objects from providers configured in the same way. The
+ * serialization of the objects is up to their providers.
+ *
+ * Only providers that allow it are cached. A provider is also not cached
+ * if its parameters can't be hashed, e.g. if it has a parameter type
+ * the configuration cache can't write.
+ *
+ * ## File Layout
+ * magic, size of serialized object, serialized object, magic
+ */
+class ConditionsDiskCache {
+ public:
+  /**
+   * Use the input directory for the cache
+   *
+   * @param[in] directory directory to store cache files in
+   */
+  ConditionsDiskCache(const std::string &directory);
+
+  /**
+   * Look for a cached version of a condition valid for the input event
+   *
+   * @param[in] name name of the condition
+   * @param[in] provider provider of the condition, used to read the object
+   * @param[in] context header of the event the condition is for
+   * @returns new conditions object (nullptr if not cached) and its IOV
+   */
+  std::pair<const ConditionsObject *, ConditionsIOV> get(
+      const std::string &name, const ConditionsObjectProvider &provider,
+      const ldmx::EventHeader &context) const;
+
+  /**
+   * Put a condition into the cache
+   *
+   * Nothing is done if the provider can't serialize the object.
+   *
+   * @param[in] name name of the condition
+   * @param[in] provider provider of the condition, used to write the object
+   * @param[in] obj conditions object to store
+   * @param[in] iov interval of validity of the object
+   */
+  void put(const std::string &name, const ConditionsObjectProvider &provider,
+           const ConditionsObject *obj, const ConditionsIOV &iov) const;
+
+ private:
+  /**
+   * Get the directory the cache files of a condition are in
+   *
+   * The parameters of a provider are only hashed the first time
+   * one of its conditions is looked for.
+   *
+   * @param[in] name name of the condition
+   * @param[in] provider provider of the condition
+   * @returns path to the directory, empty if the provider isn't cached
+   */
+  std::string directory(const std::string &name,
+                        const ConditionsObjectProvider &provider) const;
+
+  /**
+   * Read an object from a cache file
+   *
+   * @param[in] path cache file
+   * @param[in] provider provider to deserialize the object with
+   * @returns new conditions object, nullptr if the file isn't valid
+   */
+  const ConditionsObject *read(const std::string &path,
+                               const ConditionsObjectProvider &provider) const;
+
+  /// directory the cache files are in
+  std::string directory_;
+
+  /// hashes of the parameters of the providers, empty if not cached
+  mutable std::map<const ConditionsObjectProvider *, std::string> hashes_;
+
+  /// guards the hashes, conditions may be loaded from several threads
+  mutable std::mutex hashesMutex_;
+
+  enableLogging("ConditionsDiskCache")
+};
+
+}  // namespace framework
+
+#endif  // FRAMEWORK_CONDITIONSDISKCACHE_H_
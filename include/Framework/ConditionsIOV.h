@@ -60,6 +60,18 @@ class ConditionsIOV {
         validForData_{validForData},
         validForMC_{validForMC} {}
 
+  /** @return first run this condition is valid for, -1 if all runs */
+  int getFirstRun() const { return firstRun_; }
+
+  /** @return last run this condition is valid for, -1 if all runs */
+  int getLastRun() const { return lastRun_; }
+
+  /** @return true if this condition is valid for real data */
+  bool isValidForData() const { return validForData_; }
+
+  /** @return true if this condition is valid for simulation */
+  bool isValidForMC() const { return validForMC_; }
+
   /** Checks to see if this condition is valid for the given event using
    * information from the header */
   bool validForEvent(const ldmx::EventHeader& eh) const;
@@ -90,6 +90,45 @@ class ConditionsObjectProvider {
     delete co;
   }
 
+  /**
+   * Should the objects of this provider be put into the disk cache?
+   *
+   * Cached objects are kept apart by the tag, IOV and parameters of
+   * their provider, so only providers whose objects depend on nothing
+   * else should opt into caching. Providers whose objects hold handles
+   * to external resources or state that is filled lazily must not.
+   *
+   * @returns false unless a provider overrides it
+   */
+  virtual bool allowsDiskCache() const { return false; }
+
+  /**
+   * Serialize a conditions object from this provider for the disk cache
+   *
+   * Only used if the provider allows caching. The default serializes
+   * the object with the ROOT dictionary of its class, so objects whose
+   * class has no dictionary (or no default constructor) are not cached.
+   *
+   * @param[in] co ConditionsObject to serialize
+   * @param[out] buffer buffer to append the serialized object to
+   * @returns false if the object can't be cached
+   */
+  virtual bool writeConditionsObject(const ConditionsObject* co,
+                                     std::string& buffer) const;
+
+  /**
+   * Recreate a conditions object from the disk cache
+   *
+   * The object is released with releaseConditionsObject like the
+   * ones returned by getCondition.
+   *
+   * @param[in] buffer serialized object written by writeConditionsObject
+   * @param[in] size size of the buffer
+   * @returns new conditions object, nullptr if it can't be read
+   */
+  virtual const ConditionsObject* readConditionsObject(const char* buffer,
+                                                       std::size_t size) const;
+
   /**
    * Callback for the ConditionsObjectProvider to take any necessary
    * action when the processing of events starts.
@@ -126,6 +165,15 @@ class ConditionsObjectProvider {
    */
   const std::string& getTagName() const { return tagname_; }
 
+  /**
+   * Get the parameters this provider was configured with
+   *
+   * The parameters include the class name of the provider.
+   */
+  const framework::config::Parameters& getParameters() const {
+    return parameters_;
+  }
+
  protected:
   /** Request another condition needed to construct this condition */
   std::pair<const ConditionsObject*, ConditionsIOV> requestParentCondition(
@@ -146,6 +194,9 @@ class ConditionsObjectProvider {
 
   /** The tag name for the ConditionsObjectProvider. */
   std::string tagname_;
+
+  /** The parameters of the ConditionsObjectProvider. */
+  framework::config::Parameters parameters_;
 };
 
 }  // namespace framework
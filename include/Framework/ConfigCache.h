@@ -0,0 +1,96 @@
+#ifndef FRAMEWORK_CONFIGCACHE_H_
+#define FRAMEWORK_CONFIGCACHE_H_
+
+/*~~~~~~~~~~~~~~~~*/
+/*   C++ StdLib   */
+/*~~~~~~~~~~~~~~~~*/
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+/*~~~~~~~~~~~~~~~*/
+/*   Framework   */
+/*~~~~~~~~~~~~~~~*/
+#include "Framework/Configure/Parameters.h"
+
+namespace framework {
+namespace config {
+
+/**
+ * Hash the source of a configuration
+ *
+ * The hash covers the contents of the python script and the arguments
+ * given to it, but not the modules the script imports.
+ *
+ * @throws Exception if the script can't be read
+ *
+ * @param[in] pythonScript name of the configuration script
+ * @param[in] args arguments to the script
+ * @param[in] nargs number of arguments
+ * @return 64-bit hash identifying the source of the configuration
+ */
+uint64_t hashSource(const std::string& pythonScript, char* args[], int nargs);
+
+/**
+ * Hash a set of parameters
+ *
+ * Two sets of parameters have the same hash if they hold the same
+ * names, types and values.
+ *
+ * @throws Exception if a parameter has a type we can't write
+ *
+ * @param[in] parameters parameters to hash
+ * @return 64-bit hash of the parameters
+ */
+uint64_t hashParameters(const Parameters& parameters);
+
+/**
+ * Write parameters into a compact binary form
+ *
+ * @throws Exception if a parameter has a type we can't write
+ *
+ * @param[in,out] out stream to write to
+ * @param[in] parameters parameters to write
+ */
+void writeParameters(std::ostream& out, const Parameters& parameters);
+
+/**
+ * Read parameters written by writeParameters
+ *
+ * @throws Exception if the stream ends early or is corrupted
+ *
+ * @param[in,out] in stream to read from
+ * @return the parameters that were written
+ */
+Parameters readParameters(std::istream& in);
+
+/**
+ * Load a configuration from a cache file
+ *
+ * @param[in] cacheFile name of the cache file
+ * @param[in] hash hash of the source the configuration should come from
+ * @param[out] configuration the cached configuration
+ * @return false if there is no cache file or it is for another source
+ */
+bool readCache(const std::string& cacheFile, uint64_t hash,
+               Parameters& configuration);
+
+/**
+ * Write a configuration into a cache file
+ *
+ * The file is written next to its final name and then moved into
+ * place, so that jobs sharing the cache never read a partial file.
+ *
+ * @throws Exception if the cache file can't be written
+ *
+ * @param[in] cacheFile name of the cache file
+ * @param[in] hash hash of the source of the configuration
+ * @param[in] configuration the configuration to cache
+ */
+void writeCache(const std::string& cacheFile, uint64_t hash,
+                const Parameters& configuration);
+
+}  // namespace config
+}  // namespace framework
+
+#endif  // FRAMEWORK_CONFIGCACHE_H_
@@ -107,6 +107,43 @@ class Parameters {
     }
   }
 
+  /**
+   * Retrieve a reference to the parameter of the given name.
+   *
+   * Unlike getParameter, the parameter is not copied. This is helpful
+   * for large tables (e.g. numpy arrays given in the configuration)
+   * which can be read in place for as long as these parameters live.
+   *
+   * @throw Exception if parameter of the given name isn't found
+   *
+   * @throw Exception if parameter is found but not of the input type
+   *
+   * @param T the data type of the parameter.
+   *
+   * @param[in] name the name of the parameter value to retrieve.
+   *
+   * @return reference to the user specified parameter of type T.
+   */
+  template <typename T>
+  const T& getParameterRef(const std::string& name) const {
+    auto parameter{parameters_.find(name)};
+    if (parameter == parameters_.end()) {
+      EXCEPTION_RAISE(
+          "NonExistParam",
+          "Parameter '" + name + "' does not exist in list of parameters.");
+    }
+
+    const T* value{std::any_cast<T>(&parameter->second)};
+    if (value == nullptr) {
+      EXCEPTION_RAISE("BadTypeParam",
+                      "Parameter '" + name + "' of type '" +
+                          parameter->second.type().name() +
+                          "' is being cast to incorrect type '" +
+                          typeid(T).name() + "'.");
+    }
+    return *value;
+  }
+
   /**
    * Retrieve a parameter with a default specified.
    *
@@ -122,6 +159,15 @@ class Parameters {
     return getParameter<T>(name);
   }
 
+  /**
+   * Get the mapping of parameter names to value.
+   *
+   * @return the map of all parameters
+   */
+  const std::map<std::string, std::any>& getParameters() const {
+    return parameters_;
+  }
+
   /**
    * Get a list of the keys available.
    * This may be helpful in debugging to make sure the parameters are spelled
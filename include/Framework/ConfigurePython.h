@@ -43,11 +43,21 @@ class ConfigurePython {
    * can get up to a whole lot of shenanigans that can help them
    * make their work more efficient.
    *
+   * If a cache file is given and it was written from the same script
+   * and arguments, the configuration is read from it and python is
+   * never started. Otherwise the script is run and the resulting
+   * configuration is written into the cache file for the next time.
+   * Only the script and its arguments are checked, so the cache
+   * needs to be removed by hand if any imported python module or
+   * other input to the script changes.
+   *
    * @param pythonScript Filename location of the python script.
    * @param args Commandline arguments to be passed to the python script.
    * @param nargs Number of commandline arguments.
+   * @param cacheFile Filename of the configuration cache, empty for no cache.
    */
-  ConfigurePython(const std::string& pythonScript, char* args[], int nargs);
+  ConfigurePython(const std::string& pythonScript, char* args[], int nargs,
+                  const std::string& cacheFile = "");
 
   /**
    * Class destructor.
@@ -71,6 +81,15 @@ class ConfigurePython {
   const framework::config::Parameters get() const { return configuration_; }
 
  private:
+  /**
+   * Run the python script and gather its configuration
+   *
+   * @param pythonScript Filename location of the python script.
+   * @param args Commandline arguments to be passed to the python script.
+   * @param nargs Number of commandline arguments.
+   */
+  void runScript(const std::string& pythonScript, char* args[], int nargs);
+
   /**
    * The entire configuration for this process
    *
@@ -13,9 +13,11 @@
 
 // LDMX
 #include "Framework/Bus.h"
+#include "Framework/EventCache.h"
 #include "Framework/EventHeader.h"
 #include "Framework/Exception/Exception.h"
 #include "Framework/ProductTag.h"
+#include "Framework/RNTupleIO.h"
 
 // STL
 #include <regex.h>
@@ -23,9 +25,11 @@
 #include <algorithm>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 
 namespace framework {
 
@@ -33,9 +37,9 @@ namespace framework {
  * @class Event
  * @brief Implements an event buffer system for storing event data
  *
- * Event data is stored in ROOT trees and branches for persistency.
- * For the buffering, we use a multi-layered inheritance tree that
- * is wrapped inside of the Bus class.
+ * Event data is stored in ROOT trees and branches (or in an RNTuple)
+ * for persistency. For the buffering, we use a multi-layered inheritance
+ * tree that is wrapped inside of the Bus class.
  * @see framework::Bus for this buffering tool
  */
 class Event {
@@ -144,6 +148,17 @@ class Event {
    */
   void addDrop(const std::string &exp);
 
+  /**
+   * Add the output tree of another output stream
+   *
+   * New products are attached to this tree as well, unless their
+   * branch name matches one of the drop rules of the stream.
+   *
+   * @param tree output tree of the stream
+   * @param drops regex expressions of the branches not to store in it
+   */
+  void addStreamTree(TTree *tree, const std::vector<std::string> &drops);
+
   /**
    * Adds an object to the event bus
    *
@@ -171,6 +186,10 @@ class Event {
    */
   template <typename T>
   void add(const std::string &collectionName, T &obj) {
+    // processors running at the same time share this event
+    std::unique_lock<std::recursive_mutex> lock(mutex_, std::defer_lock);
+    if (concurrent_) lock.lock();
+
     if (collectionName.find('_') != std::string::npos) {
       EXCEPTION_RAISE("IllegalName",
                       "The product name '" + collectionName +
@@ -178,19 +197,16 @@ class Event {
     }
 
     // determine the branch name
-    std::string branchName;
-    if (collectionName == ldmx::EventHeader::BRANCH)
-      branchName = collectionName;
-    else
-      branchName = makeBranchName(collectionName);
+    const std::string &branchName{addedBranchName(collectionName)};
 
-    if (branchesFilled_.find(branchName) != branchesFilled_.end()) {
+    bool &filled{branchesFilled_[branchName]};
+    if (filled) {
       EXCEPTION_RAISE("ProductExists",
                       "A product named '" + collectionName +
                           "' already exists in the event (has been loaded by a "
                           "previous producer in this process).");
     }
-    branchesFilled_.insert(branchName);
+    filled = true;
     // MEMORY add is leaking memory when given a vector (possible upon
     // destruction of Event?) MEMORY add is 'conditional jump or move depends on
     // uninitialised values' for all types of objects
@@ -202,24 +218,7 @@ class Event {
       bus_.board<T>(branchName);
 
       // type name (want to use branch element if possible)
-      std::string tname = typeid(obj).name();
-
-      if (outputTree_ and not shouldDrop(branchName)) {
-        // we are writing this branch to an output file, so let's
-        //  attach this passenger to the output tree
-        TBranch *outBranch = bus_.attach(outputTree_, branchName, true);
-        // get type name from branch if possible,
-        //  otherwise use compiler level type name (above)
-        std::string class_name{outBranch->GetClassName()};
-        if (not class_name.empty()) tname = class_name;
-      }  // output tree exists or not
-
-      // check for cache entry to remove
-      auto it_known{knownLookups_.find(collectionName)};
-      if (it_known != knownLookups_.end()) knownLookups_.erase(it_known);
-
-      // add us to list of products
-      products_.emplace_back(collectionName, passName_, tname);
+      newProduct(collectionName, branchName, typeid(obj).name());
     }
 
     // copy input contents into bus passenger
@@ -276,13 +275,19 @@ class Event {
   template <typename T>
   const T &getObject(const std::string &collectionName,
                      const std::string &passName = "") const {
-    // get branch name
-    std::string branchName;
+    // processors running at the same time share this event
+    std::unique_lock<std::recursive_mutex> lock(mutex_, std::defer_lock);
+    if (concurrent_) lock.lock();
+
+    // get branch name, the names are cached so that we don't
+    //  build (and allocate) the same strings every event
+    const std::string *branchNamePtr{nullptr};
     if (collectionName == ldmx::EventHeader::BRANCH) {
-      branchName = collectionName;
+      branchNamePtr = &collectionName;
     } else if (passName.empty()) {
       // if no passName, then find branchName by looking over known products
-      if (knownLookups_.find(collectionName) == knownLookups_.end()) {
+      auto known{knownLookups_.find(collectionName)};
+      if (known == knownLookups_.end()) {
         // this collectionName hasn't been found before
         //   this collection name is the whole name and not a partial name
         //   so we search products with a full-string match required
@@ -303,20 +308,60 @@ class Event {
                               "' without specified pass name :" + names.str());
         } else {
           // exactly one branch found -> cache for later
-          knownLookups_[collectionName] =
-              makeBranchName(collectionName, matches.at(0).passname());
+          known = knownLookups_
+                      .emplace(collectionName,
+                               makeBranchName(collectionName,
+                                              matches.at(0).passname()))
+                      .first;
         }  // different options for number of possible branch matches
       }    // collection not in known lookups
-      branchName = knownLookups_.at(collectionName);
+      branchNamePtr = &known->second;
     } else {
-      branchName = makeBranchName(collectionName, passName);
+      auto &lookups{passLookups_[passName]};
+      auto known{lookups.find(collectionName)};
+      if (known == lookups.end()) {
+        known = lookups
+                    .emplace(collectionName,
+                             makeBranchName(collectionName, passName))
+                    .first;
+      }
+      branchNamePtr = &known->second;
     }
+    const std::string &branchName{*branchNamePtr};
 
     // now we have determined the unique branch name to look for
     //  so we can start looking on the bus and the input tree
     //  (if it exists) for it
     bool already_on_board{bus_.isOnBoard(branchName)};
-    if (not already_on_board and inputTree_) {
+    if (not already_on_board and inputCache_ and inputCache_->has(branchName)) {
+      // branch is not on the bus but it is in the local event cache
+      //  -> read it from the cache instead of the input tree
+      if (inputCache_->getReadEntry() < 0) {
+        EXCEPTION_RAISE("InTreeInit",
+                        "The event cache was un-initialized when attempting "
+                        "to get '" +
+                            branchName + "'.");
+      }
+      bus_.board<T>(branchName);
+      inputCache_->connect(branchName, bus_.address(branchName));
+    } else if (not already_on_board and inputNTuple_) {
+      // branch is not on the bus but there is an input RNTuple
+      //  -> connect a new passenger to the field of the same name
+      if (inputNTuple_->getReadEntry() < 0) {
+        EXCEPTION_RAISE("InTreeInit",
+                        "The input RNTuple was un-initialized when attempting "
+                        "to get '" +
+                            branchName + "'.");
+      }
+      bus_.board<T>(branchName);
+      if (not inputNTuple_->connect(branchName, bus_.address(branchName))) {
+        // don't leave an unconnected passenger on the bus
+        bus_.getOff(branchName);
+        EXCEPTION_RAISE("ProductNotFound", "No product found for field '" +
+                                               branchName +
+                                               "' on input RNTuple.");
+      }
+    } else if (not already_on_board and inputTree_) {
       // branch is not on the bus but there is an input tree
       //  -> let's look for a new branch to load
 
@@ -327,6 +372,7 @@ class Event {
       TBranch *branch = bus_.attach(inputTree_, branchName, false);
       if (branch == 0) {
         // inputTree doesn't have that branch
+        bus_.getOff(branchName);
         EXCEPTION_RAISE("ProductNotFound", "No product found for branch '" +
                                                branchName + "' on input tree.");
       }
@@ -413,6 +459,36 @@ class Event {
    */
   void setInputTree(TTree *tree);
 
+  /**
+   * Set the input RNTuple
+   *
+   * This is used instead of setInputTree if the input
+   * file stores its events in an RNTuple.
+   *
+   * @param source The input RNTuple
+   */
+  void setInputNTuple(RNTupleSource *source);
+
+  /**
+   * Set the output RNTuple
+   *
+   * This is used instead of setOutputTree if the output
+   * file should store its events in an RNTuple.
+   *
+   * @param sink The output RNTuple
+   */
+  void setOutputNTuple(RNTupleSink *sink);
+
+  /**
+   * Set the local cache of the input file
+   *
+   * Branches stored in the cache are read from it instead
+   * of the input tree.
+   *
+   * @param cache The cache of the current input file
+   */
+  void setInputCache(EventCache *cache) { inputCache_ = cache; }
+
   /**
    * Set the output data tree.
    * @param tree The output data tree.
@@ -442,6 +518,18 @@ class Event {
    */
   bool nextEvent();
 
+  /**
+   * Take the products added to another event during processing
+   *
+   * The event header and the products are moved into this event
+   * (which is the one connected to the output) and the other event
+   * is cleared so it can be used for processing another event.
+   * This is how events processed in a pipeline are written out.
+   *
+   * @param[in,out] from event to take the products of
+   */
+  void takeProducts(Event &from);
+
   /**
    * Action to be executed before the tree is filled.
    */
@@ -483,6 +571,19 @@ class Event {
     electronCount_ = electronCount;
   }
 
+  /**
+   * Set if processors may access this event from several threads at once
+   *
+   * Adding and getting objects is serialized when this is on so that
+   * processors that don't depend on each other can run concurrently.
+   * The objects themselves are not protected, processors declare which
+   * collections they use so that nobody changes an object while
+   * another processor reads it.
+   *
+   * @param[in] concurrent true if the event is shared between threads
+   */
+  void setConcurrent(bool concurrent) { concurrent_ = concurrent; }
+
  private:
   /**
    * Check if collection should be dropped.
@@ -492,6 +593,19 @@ class Event {
    */
   bool shouldDrop(const std::string &collName) const;
 
+  /**
+   * Register a passenger that just boarded the bus as a new product
+   *
+   * If we are writing an output file (and the product isn't dropped),
+   * the passenger is attached to the output tree or RNTuple.
+   *
+   * @param collectionName name of the collection
+   * @param branchName name of the passenger on the bus
+   * @param tname type name to use if the output doesn't provide one
+   */
+  void newProduct(const std::string &collectionName,
+                  const std::string &branchName, std::string tname);
+
   /**
    * Make a branch name from a collection and pass name.
    * @param collectionName The collection name.
@@ -510,6 +624,25 @@ class Event {
     return makeBranchName(collectionName, passName_);
   }
 
+  /**
+   * Get the branch name of a collection added in this pass
+   *
+   * The names are cached so they are only built once.
+   *
+   * @param collectionName The collection name.
+   * @return branch name for the collection with the current pass
+   */
+  const std::string &addedBranchName(const std::string &collectionName) {
+    if (collectionName == ldmx::EventHeader::BRANCH) return collectionName;
+    auto it{addedBranchNames_.find(collectionName)};
+    if (it == addedBranchNames_.end()) {
+      it = addedBranchNames_
+               .emplace(collectionName, makeBranchName(collectionName))
+               .first;
+    }
+    return it->second;
+  }
+
  private:
   /**
    * The event header object.
@@ -531,6 +664,36 @@ class Event {
    */
   TTree *inputTree_{nullptr};
 
+  /**
+   * The output RNTuple for writing a new file.
+   */
+  RNTupleSink *outputNTuple_{nullptr};
+
+  /**
+   * The output tree of another output stream and what it drops
+   */
+  struct StreamTree {
+    /// the tree owned by the stream's output file
+    TTree *tree;
+    /// regex of collection names to not store in this tree
+    std::vector<regex_t> drops;
+  };
+
+  /**
+   * The output trees of the other output streams
+   */
+  std::vector<StreamTree> streamTrees_;
+
+  /**
+   * The input RNTuple for reading existing data.
+   */
+  RNTupleSource *inputNTuple_{nullptr};
+
+  /**
+   * The local cache of the input file.
+   */
+  EventCache *inputCache_{nullptr};
+
   /// The total number of electrons in the event
   int electronCount_{1};
 
@@ -545,14 +708,21 @@ class Event {
   mutable framework::Bus bus_;
 
   /**
-   * Names of branches filled during this event.
+   * Flags for the branches filled during this event.
    *
    * This is used to make sure the same passenger isn't
    * modified more than once in one event _and_ to make
    * sure the event header is updated if it wasn't updated
-   * manually.
+   * manually. The branches stay in the map between events
+   * and only their flags are reset, so marking a branch as
+   * filled doesn't allocate once it has been filled before.
    */
-  std::set<std::string> branchesFilled_;
+  std::unordered_map<std::string, bool> branchesFilled_;
+
+  /**
+   * Branch names for the collections added in this pass
+   */
+  std::unordered_map<std::string, std::string> addedBranchNames_;
 
   /**
    * Regex of collection names to *not* store in event.
@@ -564,10 +734,27 @@ class Event {
    */
   mutable std::map<std::string, std::string> knownLookups_;
 
+  /**
+   * Efficiency cache for branch names of lookups with a pass name,
+   * the outer key is the pass name and the inner key the collection name
+   */
+  mutable std::unordered_map<std::string,
+                             std::unordered_map<std::string, std::string>>
+      passLookups_;
+
   /**
    * List of all the event products
    */
   std::vector<ProductTag> products_;
+
+  /**
+   * Guards the bus and the bookkeeping of products while
+   * processors run concurrently
+   */
+  mutable std::recursive_mutex mutex_;
+
+  /// Is this event shared between several threads?
+  bool concurrent_{false};
 };
 }  // namespace framework
 
@@ -0,0 +1,155 @@
+#ifndef FRAMEWORK_EVENTCACHE_H_
+#define FRAMEWORK_EVENTCACHE_H_
+
+//---< C++ >---//
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//---< Framework >---//
+#include "Framework/Logger.h"
+
+class TClass;
+class TFile;
+class TTree;
+
+namespace framework {
+
+/**
+ * A local, memory-mapped cache of selected collections from an input file
+ *
+ * Analyses that loop over the same input files many times pay for
+ * reading and decompressing the same baskets on every pass. The cache
+ * stores the serialized (but uncompressed) objects from a selection of
+ * branches in a flat file which is memory-mapped on later passes. Reading
+ * an object from the cache is then just streaming it out of memory
+ * without any file access or decompression.
+ *
+ * The cache file is named after a hash of the input file's UUID and size,
+ * the number of entries in the event tree, and the list of cached branches.
+ * If no cache file exists yet, it is built when the input file is opened
+ * by reading the selected branches once.
+ *
+ * ## File Layout
+ * All integers are stored in the native layout of this machine since the
+ * cache is only meant to be used locally.
+ * - header: magic, number of entries, number of branches
+ * - branch table: name, class name (empty for basic types), basic type size
+ * - data: the serialized objects, entry by entry and branch by branch
+ * - index: offsets of each object in the data (plus one for the end)
+ * - footer: position of the index, magic
+ */
+class EventCache {
+ public:
+  /**
+   * Open the cache for the input tree, building it if necessary
+   *
+   * @param[in] file input file the tree comes from
+   * @param[in] tree input event tree
+   * @param[in] directory directory to store cache files in
+   * @param[in] collections regular expressions for the branches to cache
+   */
+  EventCache(TFile *file, TTree *tree, const std::string &directory,
+             const std::vector<std::string> &collections);
+
+  /// Unmap the cache file
+  ~EventCache();
+
+  /// @return list of branches that are stored in the cache
+  std::vector<std::string> getBranches() const;
+
+  /**
+   * Check if the input branch is in the cache
+   *
+   * @param[in] branch name of branch to look for
+   * @return true if the branch is stored in the cache
+   */
+  bool has(const std::string &branch) const;
+
+  /**
+   * Connect an object to a branch in the cache
+   *
+   * The current entry is loaded into the object immediately.
+   *
+   * @param[in] branch name of branch to read
+   * @param[in] address pointer to the object to read into
+   */
+  void connect(const std::string &branch, void *address);
+
+  /**
+   * Load the input entry into all of the connected objects
+   *
+   * @param[in] entry index of entry to load
+   */
+  void setEntry(long long entry);
+
+  /// @return the current entry, negative if no entry has been loaded
+  long long getReadEntry() const { return entry_; }
+
+ private:
+  /// information about each branch in the cache
+  struct Branch {
+    /// name of the branch
+    std::string name_;
+    /// class of the objects, nullptr for basic types
+    TClass *class_;
+    /// size of the basic type
+    std::uint32_t size_;
+  };
+
+  /**
+   * Write the cache file from the input tree
+   *
+   * @param[in] tree input tree to read the branches from
+   * @param[in] path file to write the cache into
+   */
+  void build(TTree *tree, const std::string &path);
+
+  /**
+   * Map the cache file into memory and read its header
+   *
+   * @param[in] path cache file
+   * @param[in] entries number of entries the cache should have
+   * @return true if the cache could be mapped and matches our expectations
+   */
+  bool open(const std::string &path, long long entries);
+
+  /**
+   * Load the object for the input branch and entry
+   *
+   * @param[in] i_branch index of branch in the cache
+   * @param[in] address pointer to object to read into
+   */
+  void load(std::size_t i_branch, void *address) const;
+
+ private:
+  /// the branches in the cache
+  std::vector<Branch> branches_;
+
+  /// the connected branches and where to load them to
+  std::vector<std::pair<std::size_t, void *>> connected_;
+
+  /// the mapped file
+  char *map_{nullptr};
+
+  /// size of the mapped file
+  std::size_t map_size_{0};
+
+  /// the data section of the mapped file
+  const char *data_{nullptr};
+
+  /// the index section of the mapped file
+  const std::uint64_t *index_{nullptr};
+
+  /// the number of entries in the cache
+  long long entries_{0};
+
+  /// the current entry
+  long long entry_{-1};
+
+  enableLogging("EventCache")
+};
+
+}  // namespace framework
+
+#endif  // FRAMEWORK_EVENTCACHE_H_
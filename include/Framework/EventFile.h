@@ -3,12 +3,16 @@
 
 //---< C++ >---//
 #include <map>
+#include <memory>
+#include <regex>
 #include <string>
 #include <vector>
 
 //---< Framework >---//
 #include "Framework/Configure/Parameters.h"
 #include "Framework/Event.h"
+#include "Framework/EventCache.h"
+#include "Framework/RNTupleIO.h"
 
 //---< ROOT >---//
 #include "TFile.h"
@@ -22,6 +26,18 @@ namespace framework {
 
 /**
  * This class manages all ROOT file input/output operations.
+ *
+ * The events themselves can be stored in two different ways.
+ * By default, they are stored in a TTree; however, output files
+ * can be configured to use an RNTuple instead by setting the
+ * 'storageBackend' parameter to 'RNTuple'. Input files are checked
+ * for which type of object they store their events in, so the
+ * storage can be chosen file by file.
+ *
+ * @note Copying events from an input RNTuple into an output file
+ * or writing an output RNTuple while reading input files is not
+ * supported. RNTuple input files can be analyzed (no output event file)
+ * and RNTuple output files can be written when producing events.
  */
 class EventFile {
  public:
@@ -98,7 +114,8 @@ class EventFile {
   /**
    * Add a rule for dropping collections from the output.
    *
-   * This needs to be called *after* setupEvent.
+   * This needs to be called *after* setupEvent, or *before* setupStream
+   * for the file of an output stream.
    * This method uses the event to help drop collections.
    *
    * The rules should be of the following form:
@@ -136,12 +153,52 @@ class EventFile {
    */
   void addDrop(const std::string &rule);
 
+  /**
+   * Read the input collections from a local cache
+   *
+   * This should be called *before* setupEvent and only for
+   * input files that are not copied into an output file.
+   * The cache is built if it doesn't exist yet and the cached
+   * branches are turned off on the input tree, so they are only
+   * read from the cache.
+   *
+   * @see EventCache for how the cache is stored
+   *
+   * @param[in] directory directory to store caches in
+   * @param[in] collections regular expressions of branch names to cache
+   */
+  void useCache(const std::string &directory,
+                const std::vector<std::string> &collections);
+
   /**
    * Set an Event object containing the event data to work with this file.
    * @param evt The Event object with event data.
    */
   void setupEvent(Event *evt);
 
+  /**
+   * Write the events of an Event object into this file as an extra stream
+   *
+   * The file of an output stream is filled next to the file set up with
+   * setupEvent, so it doesn't move the event along and has its own drop
+   * and keep rules. This needs to be called *after* addDrop.
+   *
+   * @throws Exception if this is not an output file with a TTree
+   *
+   * @param evt The Event object with event data.
+   */
+  void setupStream(Event *evt);
+
+  /**
+   * Fill the current event into the tree of an output stream
+   *
+   * Unlike nextEvent, this leaves the event as it is so that other
+   * files can write it as well.
+   *
+   * @param[in] storeCurrentEvent true if the event should be stored
+   */
+  void fillStream(bool storeCurrentEvent);
+
   /**
    * Change pointer to different parent file.
    *
@@ -225,6 +282,14 @@ class EventFile {
    */
   ldmx::RunHeader *getRunHeaderPtr(int runNumber);
 
+  /**
+   * Get the RunHeader for the run after the given one in the input file.
+   * @param[in] runNumber The run number.
+   * @return pointer to the header with the next larger run number
+   * @note the returned pointer will be nullptr if there are no later runs
+   */
+  ldmx::RunHeader *getNextRunHeaderPtr(int runNumber);
+
   /**
    * Get the RunHeader for a given run, if it exists in the input file.
    * @param runNumber The run number.
@@ -237,6 +302,12 @@ class EventFile {
   /// @return the name of the ROOT file being managed.
   const std::string &getFileName() { return fileName_; }
 
+  /// @return the tree with the event data, nullptr if they are in an RNTuple
+  TTree *getTree() { return tree_; }
+
+  /// @return the number of events in an input file
+  Long64_t getEntries() const { return entries_; }
+
  private:
   /**
    * Fill the internal map of run numbers to RunHeader objects from the input
@@ -256,6 +327,26 @@ class EventFile {
    */
   void importRunHeaders();
 
+  /**
+   * Apply the per-branch compression rules to any new branches
+   *
+   * Branches can be added to the output tree during the processing
+   * of any event, so we check for new branches before each fill.
+   * The last rule matching the name of a branch determines its
+   * compression setting, branches not matching any rule keep
+   * the compression setting of the file.
+   */
+  void applyCompressionRules();
+
+  /**
+   * Clone the structure of the parent tree into our tree
+   *
+   * Only the branches that are on after applying the pre-clone
+   * rules are cloned, the dropped ones are turned back on for
+   * reading afterwards.
+   */
+  void cloneParentTree();
+
  private:
   /// The number of entries in the tree.
   Long64_t entries_{-1};
@@ -281,6 +372,21 @@ class EventFile {
   /// The tree with event data.
   TTree *tree_{nullptr};
 
+  /// The RNTuple we write event data to (instead of tree_)
+  std::unique_ptr<RNTupleSink> ntupleSink_;
+
+  /// The RNTuple we read event data from (instead of tree_)
+  std::unique_ptr<RNTupleSource> ntupleSource_;
+
+  /// The local cache of some of the branches of tree_
+  std::unique_ptr<EventCache> cache_;
+
+  /// Branch name patterns and the compression setting to use for them
+  std::vector<std::pair<std::regex, int>> compressionRules_;
+
+  /// Number of branches of tree_ that the compression rules were applied to
+  int nBranchesCompressed_{0};
+
   /// A parent file containing event data.
   EventFile *parent_{nullptr};
 
@@ -304,6 +410,12 @@ class EventFile {
    */
   std::vector<std::string> reactivateRules_;
 
+  /**
+   * Drop rules added before this file was connected to an event,
+   * only used by the files of output streams
+   */
+  std::vector<std::string> streamDrops_;
+
   /**
    * Map of run numbers to RunHeader objects
    *
@@ -24,7 +24,10 @@
 /*   C++ StdLib   */
 /*~~~~~~~~~~~~~~~~*/
 #include <any>
+#include <functional>
 #include <map>
+#include <string>
+#include <vector>
 
 class TDirectory;
 
@@ -142,6 +145,69 @@ class EventProcessor {
     return getConditions().getCondition<T>(condition_name);
   }
 
+  /**
+   * Create a handle for quicker access to a conditions object
+   *
+   * The handle should be created once (in the constructor or configure)
+   * and kept as a member of the processor.
+   *
+   * @see ConditionHandle
+   * @tparam T type of conditions object
+   * @param[in] condition_name name of condition to access
+   * @returns handle to the condition
+   */
+  template <class T>
+  ConditionHandle<T> getConditionHandle(const std::string &condition_name) {
+    return ConditionHandle<T>(getConditions(), condition_name);
+  }
+
+  /**
+   * Declare that this processor needs a conditions object for every run
+   *
+   * Required conditions are loaded at the start of each run (and possibly
+   * in the background before it) instead of on the first request.
+   * This should be called in the constructor or configure.
+   *
+   * @param[in] condition_name name of condition this processor needs
+   */
+  void requireCondition(const std::string &condition_name);
+
+  /**
+   * Declare that this processor reads a collection from the event
+   *
+   * When the process runs processors concurrently, this processor
+   * only runs after all of the processors producing the collection.
+   * Processors that don't declare what they consume or produce are
+   * never run at the same time as any other processor.
+   * This should be called in the constructor or configure.
+   *
+   * @param[in] collection_name name of collection this processor reads
+   */
+  void consumes(const std::string &collection_name) {
+    consumes_.push_back(collection_name);
+  }
+
+  /**
+   * Declare that this processor adds a collection to the event
+   *
+   * @see consumes for how these declarations are used
+   *
+   * @param[in] collection_name name of collection this processor adds
+   */
+  void produces(const std::string &collection_name) {
+    produces_.push_back(collection_name);
+  }
+
+  /**
+   * Get the collections this processor declared it reads
+   */
+  const std::vector<std::string> &getConsumes() const { return consumes_; }
+
+  /**
+   * Get the collections this processor declared it adds
+   */
+  const std::vector<std::string> &getProduces() const { return produces_; }
+
   /**
    * Access/create a directory in the histogram file for this event
    * processor to create histograms and analysis tuples.
@@ -153,6 +219,13 @@ class EventProcessor {
    */
   TDirectory *getHistoDirectory();
 
+  /**
+   * Forget the directory in the histogram file so it is looked up again
+   *
+   * Used by the framework when it moves the histograms to another file.
+   */
+  void resetHistoDirectory() { histoDir_ = nullptr; }
+
   /** Mark the current event as having the given storage control hint from this
    * module
    * @param controlhint The storage control hint to apply for the given event
@@ -205,6 +278,33 @@ class EventProcessor {
       const std::vector<framework::config::Parameters> &histos);
 
  protected:
+  /**
+   * Call a function for each index in a range, using the threads
+   * of the process to split the work of one event
+   *
+   * The calls share the threads the process runs the sequence with
+   * (Process.numThreads) so that processors don't start their own
+   * threads on top of them. If the process runs on one thread, the
+   * function is simply called for each index in order.
+   *
+   * The function may be called for several indices at the same time,
+   * so it should only write to things that belong to its index.
+   * The calls see the same event header, conditions and storage
+   * control as the processor calling parallelFor.
+   * ```cpp
+   * std::vector<double> energy(n_layers);
+   * parallelFor(0, n_layers, [&](std::size_t layer) {
+   *   energy[layer] = reconstructLayer(layer);
+   * });
+   * ```
+   *
+   * @param[in] begin first index
+   * @param[in] end one past the last index
+   * @param[in] fn function to call with each index
+   */
+  void parallelFor(std::size_t begin, std::size_t end,
+                   const std::function<void(std::size_t)> &fn);
+
   /**
    * Abort the event immediately.
    *
@@ -240,6 +340,12 @@ class EventProcessor {
 
   /** Histogram directory */
   TDirectory *histoDir_{0};
+
+  /** Names of the collections this processor reads */
+  std::vector<std::string> consumes_;
+
+  /** Names of the collections this processor adds */
+  std::vector<std::string> produces_;
 };
 
 /**
@@ -9,8 +9,14 @@
  */
 #define BOOST_ALL_DYN_LINK 1
 
+#include <atomic>
+
 #include <boost/log/core.hpp>                 //core logging service
 #include <boost/log/expressions.hpp>          //for attributes and expressions
+#include <boost/log/sinks/async_frontend.hpp>  //asyncronous sink frontend
+#include <boost/log/sinks/block_on_overflow.hpp>   //full queue policy
+#include <boost/log/sinks/bounded_fifo_queue.hpp>  //queue of records to write
+#include <boost/log/sinks/drop_on_overflow.hpp>    //full queue policy
 #include <boost/log/sinks/sync_frontend.hpp>  //syncronous sink frontend
 #include <boost/log/sinks/text_ostream_backend.hpp>  //output stream sink backend
 #include <boost/log/sources/global_logger_storage.hpp>  //for global logger default
@@ -22,6 +28,16 @@
 #include <boost/log/sources/record_ostream.hpp>
 #include <boost/log/utility/setup/file.hpp>
 
+/**
+ * Minimum level of log messages that are compiled in
+ *
+ * Messages below this level are removed by the compiler together with
+ * the evaluation of what they would print. Set by the build.
+ */
+#ifndef FRAMEWORK_LOG_MIN_LEVEL
+#define FRAMEWORK_LOG_MIN_LEVEL 0
+#endif
+
 namespace framework {
 
 namespace logging {
@@ -68,6 +84,24 @@ const std::unordered_map<level, std::string> humanReadableLevel = {
     {error, "error"},
     {fatal, "fatal"}};
 
+/**
+ * Lowest level accepted by any of the sinks
+ *
+ * Set by open and reset by close. Checked before a record is made
+ * so messages no sink would print cost a single relaxed load.
+ */
+inline std::atomic<int> minLevel{0};
+
+/**
+ * Check if a message of the input level would be printed
+ *
+ * @param[in] lvl level of message
+ * @return true if any sink accepts messages of this level
+ */
+inline bool isEnabled(level lvl) {
+  return lvl >= minLevel.load(std::memory_order_relaxed);
+}
+
 /**
  * Short names for boost namespaces
  */
@@ -93,12 +127,23 @@ typedef log::sources::severity_channel_logger_mt<level, std::string> logger;
  */
 logger makeLogger(const std::string& name);
 
+/**
+ * Number of log records each asynchronous sink can hold before
+ * its overflow policy kicks in
+ */
+constexpr std::size_t ASYNC_QUEUE_SIZE{8192};
+
 /**
  * Initialize the logging backend
  *
  * This function setups up the terminal and file sinks.
  * Sets their format and filtering level for this run.
  *
+ * Asynchronous sinks only put the records into a queue on the logging
+ * thread, a dedicated thread for each sink formats and writes them. If
+ * the queue is full, the logging thread either waits for room or the
+ * record is dropped.
+ *
  * @note Will not setup printing log messages to file if fileName is empty
  * string.
  *
@@ -107,12 +152,33 @@ logger makeLogger(const std::string& name);
  * @param fileLevel minimum level to print to file log (everything above it is
  * also printed)
  * @param fileName name of file to print log to
+ * @param async write the records on dedicated threads
+ * @param dropOnOverflow drop records instead of waiting when the queue of
+ * an asynchronous sink is full
  */
 void open(const level termLevel, const level fileLevel,
-          const std::string& fileName);
+          const std::string& fileName, bool async = false,
+          bool dropOnOverflow = false);
+
+/**
+ * Stop the threads writing the records of asynchronous sinks
+ *
+ * The records in the queues are written out before returning and any
+ * record logged afterwards waits in the queue until resume is called.
+ * This is necessary before forking since only the forking thread
+ * is copied into the child.
+ */
+void suspend();
+
+/**
+ * Restart the threads writing the records of asynchronous sinks
+ */
+void resume();
 
 /**
  * Close up the logging
+ *
+ * Any record still queued by an asynchronous sink is written first.
  */
 void close();
 
@@ -142,7 +208,16 @@ void close();
  *
  * Assumes to have access to a variable named theLog_ of type logger.
  * Input logging level (without namespace or enum).
+ *
+ * Messages below FRAMEWORK_LOG_MIN_LEVEL are compiled out and messages
+ * that no sink would print are skipped before a record is made, in both
+ * cases the streamed values are not evaluated.
  */
-#define ldmx_log(lvl) BOOST_LOG_SEV(theLog_, ::framework::logging::level::lvl)
+#define ldmx_log(lvl)                                               \
+  if (::framework::logging::level::lvl < FRAMEWORK_LOG_MIN_LEVEL or \
+      not ::framework::logging::isEnabled(                          \
+          ::framework::logging::level::lvl)) {                      \
+  } else                                                            \
+    BOOST_LOG_SEV(theLog_, ::framework::logging::level::lvl)
 
 #endif  // FRAMEWORK_LOGGER_H
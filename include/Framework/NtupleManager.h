@@ -115,6 +115,9 @@ class NtupleManager {
   /// Reset all of the variables to their limits.
   void clear();
 
+  /// Check if any tree has been created.
+  bool hasTrees() const { return not trees_.empty(); }
+
   /**
    * Reset NtupleManager to blank state
    *
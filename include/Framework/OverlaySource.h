@@ -0,0 +1,186 @@
+#ifndef FRAMEWORK_OVERLAYSOURCE_H_
+#define FRAMEWORK_OVERLAYSOURCE_H_
+
+//---< C++ >---//
+#include <array>
+#include <cstdint>
+#include <future>
+#include <random>
+#include <string>
+#include <vector>
+
+//---< Framework >---//
+#include "Framework/Bus.h"
+#include "Framework/Configure/Parameters.h"
+#include "Framework/EventFile.h"
+#include "Framework/Exception/Exception.h"
+
+namespace framework {
+
+/**
+ * Secondary events kept in memory to be overlaid onto the primary events
+ *
+ * The collections of the secondary (e.g. pileup) events are read from a
+ * loopable EventFile into a pool of buffers. For each primary event, some
+ * of them are sampled at random from the pool and the processor reads
+ * them in place. While the primary events sample from one pool, the next
+ * pool is read on a background thread, so the overlay doesn't have to
+ * wait for the secondary file. Only the collections that were added are
+ * read from the file.
+ *
+ * @code{.cpp}
+ * // onProcessStart
+ * overlay_ = std::make_unique<framework::OverlaySource>(params, file, 500, 50);
+ * overlay_->addCollection<std::vector<ldmx::SimCalorimeterHit>>(
+ *     "EcalSimHits_sim");
+ * // onNewRun
+ * overlay_->setSeed(getCondition<RandomNumberSeedService>(
+ *     RandomNumberSeedService::CONDITIONS_OBJECT_NAME).getSeed("Overlay"));
+ * // produce
+ * overlay_->sample(n_pileup);
+ * for (std::size_t i{0}; i < overlay_->getNumSampled(); i++) {
+ *   const auto &hits{overlay_->get<std::vector<ldmx::SimCalorimeterHit>>(
+ *       i, "EcalSimHits_sim")};
+ * }
+ * @endcode
+ */
+class OverlaySource {
+ public:
+  /**
+   * Open the file of secondary events
+   *
+   * @param[in] params parameters of the EventFile, needs the tree_name
+   * @param[in] fileName name of the file with the secondary events
+   * @param[in] poolSize number of secondary events in each pool
+   * @param[in] eventsPerPool number of primary events sampling from a
+   * pool before moving on to the next one
+   * @throws Exception if the pool is empty or eventsPerPool isn't positive
+   */
+  OverlaySource(const config::Parameters &params, const std::string &fileName,
+                std::size_t poolSize, int eventsPerPool);
+
+  /**
+   * Wait for the pool being read before closing the file
+   */
+  ~OverlaySource();
+
+  /**
+   * Read a collection of the secondary events
+   *
+   * @throws Exception if called after the first sample
+   *
+   * @tparam T type of the collection
+   * @param[in] branchName full name of the branch (collection and pass)
+   */
+  template <typename T>
+  void addCollection(const std::string &branchName) {
+    if (started_) {
+      EXCEPTION_RAISE("OverlaySource",
+                      "Collections need to be added before the first "
+                      "overlay events are sampled.");
+    }
+    for (auto &pool : pools_)
+      for (auto &event : pool) event.board<T>(branchName);
+    branches_.push_back(branchName);
+  }
+
+  /**
+   * Seed the choice of secondary events, e.g. with a seed from
+   * the RandomNumberSeedService
+   *
+   * The seed also chooses where in the file we start reading, so it
+   * should be set before the first sample.
+   *
+   * @param[in] seed seed for the random engine
+   */
+  void setSeed(uint64_t seed) { engine_.seed(seed); }
+
+  /**
+   * Choose the secondary events to overlay onto the next primary event
+   *
+   * The events are drawn from the current pool with replacement.
+   * The first call reads the first pool.
+   *
+   * @param[in] n number of secondary events to choose
+   */
+  void sample(std::size_t n);
+
+  /**
+   * Get the number of secondary events chosen by the last sample
+   */
+  std::size_t getNumSampled() const { return sampled_.size(); }
+
+  /**
+   * Get a collection of one of the chosen secondary events
+   *
+   * The collection stays valid until the next sample.
+   *
+   * @throws Exception if the collection wasn't added
+   * @throws std::bad_cast if the collection was added with another type
+   *
+   * @tparam T type of the collection
+   * @param[in] i index of the chosen event, less than getNumSampled()
+   * @param[in] branchName full name of the branch (collection and pass)
+   * @returns read-only reference to the collection
+   */
+  template <typename T>
+  const T &get(std::size_t i, const std::string &branchName) {
+    Bus &event{pools_[active_][sampled_.at(i)]};
+    if (not event.isOnBoard(branchName)) {
+      EXCEPTION_RAISE("OverlaySource", "The collection '" + branchName +
+                                           "' was not added to the overlay.");
+    }
+    return event.get<T>(branchName);
+  }
+
+ private:
+  /**
+   * Turn on the branches we read, jump to a random event and read the
+   * first pool, then start reading the second one
+   *
+   * @throws Exception if the file is empty or is missing a collection
+   */
+  void start();
+
+  /**
+   * Read the next events of the file into a pool
+   *
+   * @param[in,out] pool buffers to read the events into
+   */
+  void fill(std::vector<Bus> &pool);
+
+ private:
+  /// two pools of buffers, one is sampled while the other is read
+  std::array<std::vector<Bus>, 2> pools_;
+
+  /// index of the pool being sampled from
+  int active_{0};
+
+  /// number of primary events that sampled from the active pool
+  int nSampledFromPool_{0};
+
+  /// number of primary events to sample from a pool
+  int eventsPerPool_;
+
+  /// indices of the chosen events in the active pool
+  std::vector<std::size_t> sampled_;
+
+  /// names of the branches we read
+  std::vector<std::string> branches_;
+
+  /// true once the first pool has been read
+  bool started_{false};
+
+  /// random engine choosing the events
+  std::mt19937_64 engine_;
+
+  /// reading of the pool that is not active
+  std::future<void> refill_;
+
+  /// file with the secondary events, closed before the pools are deleted
+  EventFile file_;
+};
+
+}  // namespace framework
+
+#endif  // FRAMEWORK_OVERLAYSOURCE_H_
@@ -39,6 +39,9 @@ class Tracker {
   void start(Callback cb, std::size_t i_proc);
   /// stop the timer for a specific callback and specific processor
   void stop(Callback cb, std::size_t i_proc);
+  /// inform us that a processor was skipped for the current event
+  void skip(std::size_t i_proc);
+
   /// inform us that we finished an event (and whether it was completed or not)
   void end_event(bool completed);
 
@@ -57,6 +60,12 @@ class Tracker {
   /// buffer for bool flag on if event completed
   bool event_completed_;
 
+  /// buffer for number of processors skipped in the event
+  int event_skipped_{0};
+
+  /// number of events each processor in the sequence was skipped for
+  std::vector<Long64_t> skipped_;
+
   /// timer from the first line of Process::run to the last line
   Timer absolute_;
   /**
@@ -15,6 +15,7 @@
 // STL
 #include <map>
 #include <set>
+#include <string>
 #include <vector>
 
 namespace framework {
@@ -92,6 +93,45 @@ class PluginFactory {
    */
   void loadLibrary(const std::string& libname);
 
+  /**
+   * Read an index of which library each class is registered in.
+   *
+   * With an index, libraries holding registered classes do not need to
+   * be loaded up front, createEventProcessor and
+   * createConditionsObjectProvider load the library of a class the first
+   * time it is needed.
+   *
+   * @param indexFile The index written by writeIndex.
+   * @return false if the index could not be read.
+   */
+  bool readIndex(const std::string& indexFile);
+
+  /**
+   * Write an index of which library each class is registered in.
+   *
+   * Only classes registered while loading a library with loadLibrary
+   * are included.
+   *
+   * @throws Exception if the index file can't be written
+   * @param indexFile The file to write the index to.
+   */
+  void writeIndex(const std::string& indexFile) const;
+
+  /**
+   * Check if a library is in the index.
+   *
+   * Libraries in the index can be loaded lazily while the others (for
+   * example, ones only holding ROOT dictionaries for event objects) still
+   * need to be loaded up front.
+   *
+   * Paths are compared after resolving symbolic links and relative
+   * components, so the same library can be given in different ways.
+   *
+   * @param libname The library to look for.
+   * @return true if a class registered in this library is in the index.
+   */
+  bool isIndexed(const std::string& libname) const;
+
  private:
   /**
    * Constructor
@@ -107,14 +147,32 @@ class PluginFactory {
     int classtype;
     EventProcessorMaker* ep_maker;
     ConditionsObjectProviderMaker* cop_maker;
+    std::string library;
   };
 
+  /**
+   * Find a class, loading its library from the index if needed.
+   * @param classname The name of the class to find.
+   * @return iterator to the class info, moduleInfo_.end() if not found.
+   */
+  std::map<std::string, PluginInfo>::const_iterator findClass(
+      const std::string& classname);
+
   /** A map of names to processor containers. */
   std::map<std::string, PluginInfo> moduleInfo_;
 
   /** A set of names of loaded libraries. */
   std::set<std::string> librariesLoaded_;
 
+  /** A map of class names to the library they are registered in. */
+  std::map<std::string, std::string> index_;
+
+  /** The normalized paths of the libraries in the index. */
+  std::set<std::string> indexedLibraries_;
+
+  /** The library being loaded, registered classes are in it. */
+  std::string libraryLoading_;
+
   /** Factory for creating the plugin objects. */
   static PluginFactory theFactory_;
 };
@@ -14,8 +14,11 @@
 #include "Framework/Performance/Tracker.h"
 #include "Framework/RunHeader.h"
 #include "Framework/StorageControl.h"
+#include "Framework/ThreadPool.h"
 
 // STL
+#include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
 #include <vector>
@@ -26,6 +29,7 @@ class TDirectory;
 namespace framework {
 
 class EventProcessor;
+class Producer;
 class EventFile;
 class Event;
 
@@ -64,8 +68,13 @@ class Process {
 
   /**
    * Get the pointer to the current event header, if defined
+   *
+   * In pipeline mode, this is the header of the event the calling
+   * thread is processing.
    */
-  const ldmx::EventHeader *getEventHeader() const { return eventHeader_; }
+  const ldmx::EventHeader *getEventHeader() const {
+    return threadEventHeader_ ? threadEventHeader_ : eventHeader_;
+  }
 
   /**
    * Get the pointer to the current run header, if defined
@@ -105,8 +114,69 @@ class Process {
 
   /**
    * Access the storage control unit for this process
+   *
+   * In pipeline mode, this is the storage control of the event the
+   * calling thread is processing.
+   */
+  StorageControl &getStorageController() {
+    return threadStorageController_ ? *threadStorageController_
+                                    : storageController_;
+  }
+
+  /**
+   * Add a storage hint from a processor for the current event
+   *
+   * The hint is given to the storage control of the process and to
+   * those of the output streams, which each decide on their own if
+   * they listen to it.
+   *
+   * @param[in] processor name of the processor giving the hint
+   * @param[in] hint the storage hint
+   * @param[in] purpose purpose of the hint
+   */
+  void addStorageHint(const std::string &processor, StorageControl::Hint hint,
+                      const std::string &purpose);
+
+  /**
+   * Access the threads shared by the processors
+   *
+   * @returns pointer to the thread pool, nullptr if running on one thread
+   */
+  ThreadPool *getThreadPool() const { return threadPool_.get(); }
+
+  /**
+   * Wrap a function so that it sees the event of the calling thread
+   *
+   * In pipeline mode, the header and storage control of the event the
+   * calling thread is processing are installed on whichever thread
+   * runs the returned function for as long as it runs, so that tasks
+   * split off onto the thread pool use the same event as their caller.
+   *
+   * @note The returned function refers to the input one, so it can
+   * only be used while the input one is alive.
+   *
+   * @param[in] fn function to call with each index
+   * @returns function calling fn with the event of the calling thread
    */
-  StorageControl &getStorageController() { return storageController_; }
+  std::function<void(std::size_t)> withThreadEvent(
+      const std::function<void(std::size_t)> &fn) const;
+
+  /**
+   * Group processors into levels that can be run concurrently
+   *
+   * A processor depends on an earlier one in the sequence if it
+   * consumes what the earlier one produces, produces what the earlier
+   * one consumes, or if they produce the same collection. Processors
+   * that didn't declare what they consume or produce depend on every
+   * processor before them and every processor after them depends on them.
+   * Each processor is put into the level right after the last level
+   * containing a processor it depends on.
+   *
+   * @param[in] sequence processors in the order they were configured
+   * @returns indices into the sequence of the processors in each level
+   */
+  static std::vector<std::vector<std::size_t>> makeLevels(
+      const std::vector<EventProcessor *> &sequence);
 
   /**
    * Set the pointer to the current event header, used only for tests
@@ -123,7 +193,7 @@ class Process {
    *
    * @return Process without any configuration
    */
-  static Process getDummy() { return std::move(Process()); }
+  static Process getDummy() { return Process(); }
 
  private:
   /**
@@ -143,7 +213,152 @@ class Process {
    * @param[in,out] event reference to event we are going to process
    * @returns true if event was full processed (false if aborted)
    */
-  bool process(int n, Event &event) const;
+  bool process(int n, Event &event);
+
+  /**
+   * Check if a processor should be skipped for the current event
+   *
+   * This also tells the performance tracker about the skip.
+   *
+   * @param[in] i_proc index of processor in the sequence
+   * @returns true if the processor should not be run
+   */
+  bool skipProcessor(std::size_t i_proc) const;
+
+  /**
+   * Run one processor of the sequence on the input event
+   *
+   * @throws AbortEventException if the processor aborted the event
+   *
+   * @param[in] i_proc index of processor in the sequence
+   * @param[in,out] event reference to event we are processing
+   */
+  void runProcessor(std::size_t i_proc, Event &event) const;
+
+  /**
+   * Call the produce or analyze method of one processor of the sequence
+   *
+   * @param[in] i_proc index of processor in the sequence
+   * @param[in,out] event reference to event we are processing
+   */
+  void callProcessor(std::size_t i_proc, Event &event) const;
+
+  /**
+   * Produce events with the processors split into pipeline stages
+   *
+   * Each stage runs its processors on its own thread and the events
+   * are passed from one stage to the next through bounded queues, so
+   * different stages work on different events at the same time. The
+   * events are recycled through a pool and this thread writes the
+   * finished events into the output file in order. The NtupleManager
+   * is shared by all events, so this isn't used if it has any trees.
+   *
+   * @param[in] outFile output file to write events to
+   * @param[in] theEvent event connected to the output file
+   * @returns number of events produced
+   */
+  int runPipeline(EventFile &outFile, Event &theEvent);
+
+  /**
+   * Process the events and notify the processors once we are done
+   *
+   * This is what is left of run after the processors were set up
+   * and the worker processes, if any, were started.
+   *
+   * @param[in] theEvent event bus to process the events with
+   */
+  void processEvents(Event &theEvent);
+
+  /**
+   * Fork the worker processes and split the input files between them
+   *
+   * The workers share the memory of this process as it was after
+   * the processors were set up, so this must be done before any
+   * threads are started.
+   *
+   * If there is an event limit, it is split between the workers so
+   * that they process the same events as a single process would,
+   * which means the files past the limit aren't handed out at all.
+   *
+   * @returns true in this process, false in the workers
+   */
+  bool startWorkers();
+
+  /**
+   * Take over the share of the input files of one worker
+   *
+   * A single output file and the histogram file are replaced
+   * by temporary files for this worker.
+   *
+   * @param[in] worker index of this worker
+   * @param[in] n_workers number of workers the files are split between
+   * @param[in] eventLimit number of events this worker processes,
+   * negative for all of the events in its files
+   */
+  void becomeWorker(int worker, int n_workers, int eventLimit);
+
+  /**
+   * Process the share of events of this worker and end the worker process
+   *
+   * The worker never returns into whatever called run, since that
+   * belongs to the parent process. It exits with a failure status if
+   * processing threw, which the parent picks up in mergeWorkers.
+   *
+   * @param[in] theEvent event bus to process the events with
+   */
+  [[noreturn]] void finishWorker(Event &theEvent);
+
+  /**
+   * Wait for the worker processes and merge their temporary files
+   *
+   * @throws Exception if any of the workers failed
+   */
+  void mergeWorkers();
+
+  /**
+   * Check if the current event will be dropped by every output
+   *
+   * @returns true if the storage control of the process and those
+   * of all output streams are certain to drop the event
+   */
+  bool isRejected() const;
+
+  /**
+   * Open the files of the output streams or give them a new input file
+   *
+   * @param[in] theEvent event the streams are filled from
+   * @param[in] parent input file being processed, nullptr if producing
+   * @param[in] runHeader run header to write when producing events
+   */
+  void openStreams(Event &theEvent, EventFile *parent,
+                   ldmx::RunHeader *runHeader);
+
+  /**
+   * Fill the current event into the output streams that keep it
+   *
+   * @param[in] completed true if the event was completely processed
+   */
+  void fillStreams(bool completed);
+
+  /**
+   * Write the run trees of the output streams and close their files
+   */
+  void closeStreams();
+
+  /**
+   * Configure a storage controller with the skimming rules of the process
+   *
+   * @param[in,out] storage storage controller to configure
+   */
+  void configureStorage(StorageControl &storage) const;
+
+  /**
+   * Group the processors of the sequence into levels that can
+   * be run concurrently
+   *
+   * @see makeLevels for the rules
+   */
+  void schedule();
 
   /**
    * Run through the processors and let them know
@@ -170,8 +385,8 @@ class Process {
   /** Processing pass name. */
   std::string passname_;
 
-  /** Limit on events to process. */
-  int eventLimit_;
+  /** Limit on events to process, can be lowered by any thread */
+  std::atomic<int> eventLimit_;
 
   /** The frequency with which event info is printed. */
   int logFrequency_;
@@ -185,15 +400,104 @@ class Process {
   /** Name of file to print logging to */
   std::string logFileName_;
 
+  /** Write the log records on dedicated threads */
+  bool logAsync_;
+
+  /** Drop log records instead of waiting when the logging can't keep up */
+  bool logDropOnOverflow_;
+
   /** Maximum number of attempts to make before giving up on an event */
   int maxTries_;
 
   /** Storage controller */
   StorageControl storageController_;
 
+  /** Should events be kept if no processor has an opinion? */
+  bool skimDefaultIsKeep_{true};
+
+  /** Pairs of processor and purpose patterns to listen to for skimming */
+  std::vector<std::string> skimRules_;
+
   /** Ordered list of EventProcessors to execute. */
   std::vector<EventProcessor *> sequence_;
 
+  /**
+   * A processor of the sequence with its kind resolved once
+   */
+  struct Step {
+    /// the processor
+    EventProcessor *module;
+    /// the processor if it is a producer, nullptr otherwise
+    Producer *producer;
+    /// produce or analyze the event with the processor
+    void (*call)(EventProcessor *, Event &);
+  };
+
+  /** The sequence as it is called for each event, built at configuration */
+  std::vector<Step> plan_;
+
+  /**
+   * Flag for each processor in the sequence if it only matters for
+   * events that are written to the output
+   */
+  std::vector<bool> outputOnly_;
+
+  /**
+   * Skip the output-only processors for events that are
+   * certain to be dropped
+   */
+  bool earlyReject_{false};
+
+  /**
+   * Number of threads to run the processors of the sequence with
+   *
+   * Processors that don't depend on each other are run concurrently
+   * if this is larger than one.
+   */
+  int numThreads_{1};
+
+  /**
+   * Number of processes to split the input files between
+   *
+   * The workers are forked after the processors are set up
+   * and each writes its own temporary output files which
+   * are merged once all of them are done. The event limit
+   * counts the events of all of the workers together.
+   */
+  int numWorkers_{1};
+
+  /// Process IDs of the workers, only filled in the parent process
+  std::vector<int> workerPids_;
+
+  /// Index of this worker process, negative if not a worker
+  int worker_{-1};
+
+  /**
+   * Indices of processors in the sequence grouped into levels
+   *
+   * The processors in one level don't depend on each other and
+   * only depend on processors in previous levels.
+   */
+  std::vector<std::vector<std::size_t>> levels_;
+
+  /// Threads running the processors, only created if using several threads
+  std::unique_ptr<ThreadPool> threadPool_;
+
+  /**
+   * Number of consecutive processors of the sequence in each
+   * pipeline stage, empty if not running a pipeline
+   */
+  std::vector<int> pipelineStages_;
+
+  /** Number of events in the pipeline at the same time */
+  int pipelineDepth_{8};
+
+  /** Header of the event being processed by this thread in pipeline mode */
+  static thread_local const ldmx::EventHeader *threadEventHeader_;
+
+  /** Storage control of the event being processed by this thread */
+  static thread_local StorageControl *threadStorageController_;
+
   /** Set of ConditionsProviders */
   Conditions conditions_;
 
@@ -213,12 +517,51 @@ class Process {
    */
   int compressionSetting_;
 
+  /** Number of threads ROOT can use to compress the output, zero disables
+   *
+   * This enables ROOT's implicit multi-threading so that the baskets
+   * of the different output branches are compressed in parallel when
+   * they are flushed to the output file.
+   */
+  int numIOThreads_{0};
+
   /** Set of drop/keep rules. */
   std::vector<std::string> dropKeepRules_;
 
+  /**
+   * Another output file filled from the same pass as the others
+   *
+   * Each stream has its own skimming rules deciding which events
+   * it keeps and its own drop/keep rules for the collections.
+   */
+  struct OutputStream {
+    /// name of the stream used in messages
+    std::string name;
+    /// name of the file the stream is written to
+    std::string fileName;
+    /// drop/keep rules for the collections
+    std::vector<std::string> dropKeepRules;
+    /// storage control deciding which events are kept
+    StorageControl storage;
+    /// file being written, only open while running
+    EventFile *file{nullptr};
+  };
+
+  /** Output streams written next to the output files */
+  std::vector<std::unique_ptr<OutputStream>> outputStreams_;
+
+  /** Directory to store local event caches in, empty if not caching */
+  std::string eventCacheDirectory_;
+
+  /** Regular expressions for the branches to store in the event cache */
+  std::vector<std::string> eventCacheCollections_;
+
   /** Run number to use if generating events. */
   int runForGeneration_{1};
 
+  /** Libraries in the plugin index, only loaded once a class is used */
+  std::vector<std::string> deferredLibraries_;
+
   /** Filename for histograms and other user products */
   std::string histoFilename_;
 
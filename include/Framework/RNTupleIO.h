@@ -0,0 +1,137 @@
+#ifndef FRAMEWORK_RNTUPLEIO_H_
+#define FRAMEWORK_RNTUPLEIO_H_
+
+//---< C++ >---//
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class TFile;
+
+namespace framework {
+
+/**
+ * Write event data into a ROOT RNTuple
+ *
+ * This is the RNTuple counterpart of the output TTree that
+ * an EventFile would otherwise create. Instead of branches, the
+ * Event registers the addresses of its passengers' baggage as
+ * fields of the RNTuple. Since RNTuple requires a model before
+ * any data can be written, the writer itself is only created
+ * when the first event is filled. Fields that are added after
+ * that are appended to the model through a model update.
+ *
+ * RNTuple support requires ROOT >= 6.34, attempting to construct
+ * this class with an older ROOT will throw an exception.
+ */
+class RNTupleSink {
+ public:
+  /**
+   * Prepare to write an RNTuple into the input file
+   *
+   * @param[in] file TFile to write the RNTuple into
+   * @param[in] name name of the RNTuple in the file
+   * @param[in] compression compression setting for the RNTuple
+   */
+  RNTupleSink(TFile *file, const std::string &name, int compression);
+
+  /**
+   * Commit the RNTuple to the file
+   *
+   * This needs to happen before the TFile we are writing to is closed.
+   */
+  ~RNTupleSink();
+
+  /**
+   * Add a field to the RNTuple
+   *
+   * @param[in] name name of the field (our branch name)
+   * @param[in] type ROOT name of the type stored in the field
+   * @param[in] address pointer to the object to write for each event
+   */
+  void addField(const std::string &name, const std::string &type,
+                void *address);
+
+  /**
+   * Write the current values of all fields as a new entry
+   */
+  void fill();
+
+ private:
+  /// the RNTuple objects we need, hidden so ROOT's headers are not exposed
+  struct Impl;
+
+  /// our RNTuple objects
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * Read event data from a ROOT RNTuple
+ *
+ * This is the RNTuple counterpart of the input TTree of an EventFile.
+ * Fields are only read if the Event has connected one of its passengers
+ * to them, so that (like a TTree with branches turned off) we only pay
+ * for the products that are actually requested.
+ *
+ * RNTuple support requires ROOT >= 6.34, attempting to construct
+ * this class with an older ROOT will throw an exception.
+ */
+class RNTupleSource {
+ public:
+  /**
+   * Open the RNTuple with the input name in the input file
+   *
+   * @param[in] file_name name of file to read from
+   * @param[in] name name of the RNTuple in the file
+   */
+  RNTupleSource(const std::string &file_name, const std::string &name);
+
+  /// Close the RNTuple
+  ~RNTupleSource();
+
+  /// @return the number of entries in the RNTuple
+  long long getEntries() const;
+
+  /**
+   * Get the fields stored in this RNTuple
+   *
+   * @return list of field names and their type names
+   */
+  std::vector<std::pair<std::string, std::string>> getFields() const;
+
+  /**
+   * Connect an object to a field of the RNTuple
+   *
+   * The current entry is loaded into the object if there is one.
+   *
+   * @param[in] name name of the field to read
+   * @param[in] address pointer to object to read the field into
+   * @return true if the field exists and was connected
+   */
+  bool connect(const std::string &name, void *address);
+
+  /**
+   * Load the input entry into all of the connected objects
+   *
+   * @param[in] entry index of entry to load
+   */
+  void setEntry(long long entry);
+
+  /// @return the current entry, negative if no entry has been loaded
+  long long getReadEntry() const { return entry_; }
+
+ private:
+  /// the RNTuple objects we need, hidden so ROOT's headers are not exposed
+  struct Impl;
+
+  /// our RNTuple objects
+  std::unique_ptr<Impl> impl_;
+
+  /// the current entry
+  long long entry_{-1};
+};
+
+}  // namespace framework
+
+#endif  // FRAMEWORK_RNTUPLEIO_H_
@@ -12,6 +12,7 @@
 /*~~~~~~~~~~~~~~~*/
 #include "Framework/ConditionsObject.h"
 #include "Framework/ConditionsObjectProvider.h"
+#include "Framework/RandomStream.h"
 
 namespace framework {
 
@@ -29,6 +30,11 @@ namespace framework {
  * Individual seeds are then constructed using the master seed and a simple hash
  * based on the name of the seed. Seeds can also be specified in the python
  * file, in which case no autoseeding will be performed.
+ *
+ * Processors can also draw from a separate random stream for each event,
+ * which only depends on the master seed, the name, the run and the event
+ * number. The results then don't depend on how the events were split
+ * between threads or jobs.
  */
 class RandomNumberSeedService : public ConditionsObject,
                                 public ConditionsObjectProvider {
@@ -78,6 +84,35 @@ class RandomNumberSeedService : public ConditionsObject,
    */
   uint64_t getSeed(const std::string& name) const;
 
+  /**
+   * Get the random stream of one event for a given name
+   *
+   * The stream is a counter-based generator keyed by the master seed and
+   * the name, with the run and event number in its counter, so creating
+   * it is cheap and it is independent of the streams of all other events.
+   * Unlike getSeed, this doesn't change the service, so it can be called
+   * from several threads at once.
+   *
+   * @param[in] name Name of stream, e.g. the name of the processor
+   * @param[in] run run number of the event
+   * @param[in] event event number of the event
+   * @return random stream for this event
+   */
+  RandomStream getEventStream(const std::string& name, int run,
+                              int event) const;
+
+  /**
+   * Get the random stream of one event for a given name
+   *
+   * @see getEventStream(const std::string&, int, int) const
+   *
+   * @param[in] name Name of stream, e.g. the name of the processor
+   * @param[in] header header of the event
+   * @return random stream for this event
+   */
+  RandomStream getEventStream(const std::string& name,
+                              const ldmx::EventHeader& header) const;
+
   /**
    * Get a list of all the known seeds
    *
@@ -114,6 +149,17 @@ class RandomNumberSeedService : public ConditionsObject,
   virtual void releaseConditionsObject(const ConditionsObject* co) {
   }  // it is us, never destroy it.
 
+  /**
+   * The seeds depend on the configuration and not just the tag,
+   * so the seed service is never put in the conditions disk cache.
+   *
+   * @returns false
+   */
+  virtual bool writeConditionsObject(const ConditionsObject*,
+                                     std::string&) const {
+    return false;
+  }
+
   /**
    * Stream the configuration of this object to the input ostream
    *
@@ -0,0 +1,114 @@
+#ifndef FRAMEWORK_RANDOMSTREAM_H_
+#define FRAMEWORK_RANDOMSTREAM_H_
+
+//---< C++ >---//
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace framework {
+
+/**
+ * Counter-based random number generator (Philox4x32-10)
+ *
+ * Each output block is a bijection of a 128-bit counter under a 64-bit
+ * key, so a stream is fully described by its key and where its counter
+ * starts. Jumping to any stream is O(1) and streams with different keys
+ * or counters are independent, which makes the numbers drawn for an
+ * event independent of which thread or job processes it.
+ *
+ * The algorithm is the one of Salmon et al., "Parallel Random Numbers:
+ * As Easy as 1, 2, 3" (SC11), and reproduces their known-answer tests.
+ *
+ * This class satisfies the UniformRandomBitGenerator requirements, so
+ * it can be used with the distributions of the standard library. Those
+ * distributions are implemented differently by each standard library,
+ * use uniform() if the numbers need to be identical everywhere.
+ */
+class RandomStream {
+ public:
+  /// type of the numbers generated
+  using result_type = uint32_t;
+
+  /// four words of the counter
+  using Counter = std::array<uint32_t, 4>;
+
+  /// two words of the key
+  using Key = std::array<uint32_t, 2>;
+
+  /**
+   * Create a stream
+   *
+   * The last two words of the counter are fixed for this stream, the
+   * first two count the blocks drawn from it.
+   *
+   * @param[in] key key of the stream
+   * @param[in] hi third word of the counter
+   * @param[in] top fourth word of the counter
+   */
+  RandomStream(uint64_t key, uint32_t hi, uint32_t top)
+      : key_{uint32_t(key), uint32_t(key >> 32)}, counter_{0, 0, hi, top} {}
+
+  /// smallest number generated
+  static constexpr result_type min() { return 0; }
+
+  /// largest number generated
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  /**
+   * Get the next random number of the stream
+   */
+  result_type operator()() {
+    if (used_ == 4) {
+      block_ = philox(counter_, key_);
+      if (++counter_[0] == 0) ++counter_[1];
+      used_ = 0;
+    }
+    return block_[used_++];
+  }
+
+  /**
+   * Get a uniform random number in [0,1) with 53 random bits
+   */
+  double uniform() {
+    uint64_t bits{(uint64_t((*this)()) << 32) | (*this)()};
+    return (bits >> 11) * 0x1.0p-53;
+  }
+
+  /**
+   * Run the ten rounds of Philox4x32 on a counter
+   *
+   * @param[in] counter counter to encrypt
+   * @param[in] key key to encrypt with
+   * @returns the four random words for this counter and key
+   */
+  static Counter philox(Counter counter, Key key) {
+    for (int round{0}; round < 10; round++) {
+      if (round > 0) {
+        key[0] += 0x9E3779B9;
+        key[1] += 0xBB67AE85;
+      }
+      uint64_t p0{uint64_t(0xD2511F53) * counter[0]};
+      uint64_t p1{uint64_t(0xCD9E8D57) * counter[2]};
+      counter = {uint32_t(p1 >> 32) ^ counter[1] ^ key[0], uint32_t(p1),
+                 uint32_t(p0 >> 32) ^ counter[3] ^ key[1], uint32_t(p0)};
+    }
+    return counter;
+  }
+
+ private:
+  /// key of this stream
+  Key key_;
+  /// counter of the next block
+  Counter counter_;
+  /// last block drawn
+  Counter block_{};
+  /// number of words of the last block already returned
+  int used_{4};
+};
+
+}  // namespace framework
+
+#endif  // FRAMEWORK_RANDOMSTREAM_H_
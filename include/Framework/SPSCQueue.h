@@ -0,0 +1,72 @@
+#ifndef FRAMEWORK_SPSCQUEUE_H_
+#define FRAMEWORK_SPSCQUEUE_H_
+
+//---< C++ >---//
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace framework {
+
+/**
+ * A bounded, lock-free queue between one producing and one consuming thread
+ *
+ * The producer only writes the tail and the consumer only writes the
+ * head, so neither has to wait for the other unless the queue is
+ * full or empty. Pushing and popping do not block, the caller decides
+ * how to wait if they fail.
+ *
+ * @tparam T type of object in the queue, should be cheap to copy
+ */
+template <typename T>
+class SPSCQueue {
+ public:
+  /**
+   * Create a queue holding at most the input number of objects
+   *
+   * @param[in] capacity maximum number of objects in the queue
+   */
+  SPSCQueue(std::size_t capacity) : buffer_(capacity + 1) {}
+
+  /**
+   * Put an object at the end of the queue, only called by the producer
+   *
+   * @param[in] obj object to add
+   * @returns false if the queue is full
+   */
+  bool tryPush(const T &obj) {
+    std::size_t tail{tail_.load(std::memory_order_relaxed)};
+    std::size_t next{tail + 1 == buffer_.size() ? 0 : tail + 1};
+    if (next == head_.load(std::memory_order_acquire)) return false;
+    buffer_[tail] = obj;
+    tail_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Take the object at the front of the queue, only called by the consumer
+   *
+   * @param[out] obj object taken from the queue
+   * @returns false if the queue is empty
+   */
+  bool tryPop(T &obj) {
+    std::size_t head{head_.load(std::memory_order_relaxed)};
+    if (head == tail_.load(std::memory_order_acquire)) return false;
+    obj = buffer_[head];
+    head_.store(head + 1 == buffer_.size() ? 0 : head + 1,
+                std::memory_order_release);
+    return true;
+  }
+
+ private:
+  /// storage for the objects, one slot is always left empty
+  std::vector<T> buffer_;
+  /// index of the next object to pop, kept away from the tail's cache line
+  alignas(64) std::atomic<std::size_t> head_{0};
+  /// index of the next free slot to push into
+  alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+}  // namespace framework
+
+#endif  // FRAMEWORK_SPSCQUEUE_H_
@@ -7,8 +7,10 @@
 #ifndef FRAMEWORK_STORAGECONTROL_H_
 #define FRAMEWORK_STORAGECONTROL_H_
 
+#include <mutex>
 #include <regex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace framework {
@@ -58,8 +60,12 @@ class StorageControl {
    * EventProcessor::setStorageHint during processing.
    * When a hint is added, we check it against our configured listening rules.
    * If the hint does not match any of our listening rules, then we simply
-   * ignore it by not adding it to our internal cache that will be used later
-   * when deciding to keep the event.
+   * ignore it by not counting it for the decision to keep the event.
+   *
+   * Whether a processor and purpose match any of the rules is only
+   * determined the first time that pair provides a hint, afterwards
+   * the decision is looked up in a hash table.
+   * Hints may be added from several threads at once.
    *
    * @param processor_name Name of the event processor
    * @param controlhint The storage control hint to apply for the given event
@@ -74,6 +80,7 @@ class StorageControl {
    *
    * These listening rules are regex patterns to decide if a specific hint
    * should be counted when deciding if an event should be kept.
+   * Adding a rule forgets the decisions made for previous hints.
    *
    * @param processor_pattern Regex pattern to compare with event processor
    * @param purpose_pattern Regex pattern to compare with the purpose string
@@ -99,6 +106,16 @@ class StorageControl {
    */
   bool keepEvent(bool event_completed) const;
 
+  /**
+   * Check if the current event will be dropped no matter what other
+   * hints are added for it
+   *
+   * This is only the case once one of the hints we listen to is mustDrop.
+   *
+   * @returns true if the current event is certain to be dropped
+   */
+  bool isRejected() const { return mustDrop_ > 0; }
+
  private:
   /**
    * Default state for storage control
@@ -106,12 +123,29 @@ class StorageControl {
   bool defaultIsKeep_{true};
 
   /**
-   * Collection of hints from the event processors
+   * Check if we listen to the hints from a processor with a purpose
+   *
+   * @param processor_name Name of the event processor
+   * @param purposeString Purpose of the hint
+   * @returns true if the pair matches one of the listening rules
+   */
+  bool isListening(const std::string& processor_name,
+                   const std::string& purposeString);
+
+  /**
+   * Number of hints of each kind for the current event
    *
    * These are only the hints that are from processors matching one
    * of the listening rules.
    */
-  std::vector<Hint> hints_;
+  int votesKeep_{0}, votesDrop_{0}, mustKeep_{0}, mustDrop_{0};
+
+  /**
+   * The listening decision for each processor and purpose that has
+   * provided a hint, so that the rules only need to be matched once
+   */
+  std::unordered_map<std::string, std::unordered_map<std::string, bool>>
+      listening_;
 
   /**
    * Collection of rules allowing certain processors
@@ -125,6 +159,9 @@ class StorageControl {
    *    from all processors with a specific purpose
    */
   std::vector<std::pair<std::regex, std::regex>> rules_;
+
+  /// Guards the counters and decisions while processors run concurrently
+  std::mutex mutex_;
 };
 
 /**
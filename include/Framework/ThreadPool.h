@@ -0,0 +1,130 @@
+#ifndef FRAMEWORK_THREADPOOL_H_
+#define FRAMEWORK_THREADPOOL_H_
+
+//---< C++ >---//
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace framework {
+
+/**
+ * A fixed set of threads running tasks from a shared queue
+ *
+ * Tasks are submitted in groups and the thread waiting for a group
+ * runs queued tasks itself while it waits. This means the thread that
+ * waits counts towards the threads doing the work (a pool with n workers
+ * uses n+1 threads while someone is waiting) and that groups can be
+ * waited on from within tasks without running out of threads.
+ */
+class ThreadPool {
+ public:
+  /**
+   * Start the worker threads
+   *
+   * @param[in] n_workers number of threads to start
+   */
+  ThreadPool(std::size_t n_workers);
+
+  /// Finish the queued tasks and join the worker threads
+  ~ThreadPool();
+
+  /// @return number of threads working while a group is waited on
+  std::size_t concurrency() const { return workers_.size() + 1; }
+
+  /**
+   * Call a function for each index in a range, spreading the calls
+   * over the threads of this pool
+   *
+   * The range is split into a few chunks per thread so that uneven
+   * work is balanced between the threads. This returns once the
+   * function has been called for every index and can be used from
+   * within tasks of this pool.
+   *
+   * @throws the first exception thrown by the function
+   *
+   * @param[in] begin first index
+   * @param[in] end one past the last index
+   * @param[in] fn function to call with each index
+   */
+  void parallelFor(std::size_t begin, std::size_t end,
+                   const std::function<void(std::size_t)> &fn);
+
+  /**
+   * A set of tasks that are waited on together
+   */
+  class TaskGroup {
+   public:
+    /**
+     * Create an empty group running its tasks on the input pool
+     *
+     * @param[in] pool pool to run the tasks on
+     */
+    TaskGroup(ThreadPool &pool) : pool_{pool} {}
+
+    /// Wait for the tasks that are still running, ignoring any errors
+    ~TaskGroup();
+
+    /**
+     * Queue a task to be run
+     *
+     * @param[in] task function to run
+     */
+    void run(std::function<void()> task);
+
+    /**
+     * Wait for all of the tasks in this group to finish
+     *
+     * The waiting thread runs queued tasks while it waits.
+     * If any of the tasks threw an exception, the first one
+     * is rethrown here after all of the tasks are done.
+     */
+    void wait();
+
+   private:
+    /// pool the tasks are run on
+    ThreadPool &pool_;
+    /// number of tasks that haven't finished yet, guarded by the pool's mutex
+    std::size_t pending_{0};
+    /// first exception thrown by a task, guarded by the pool's mutex
+    std::exception_ptr error_;
+  };
+
+ private:
+  /**
+   * Run one of the queued tasks if there is one
+   *
+   * @param[in] lock lock on our mutex, unlocked while the task runs
+   * @return true if a task was run
+   */
+  bool runOne(std::unique_lock<std::mutex> &lock);
+
+  /// loop run by each worker thread
+  void work();
+
+  /// tasks waiting to be run
+  std::deque<std::function<void()>> queue_;
+
+  /// guards the queue and the state of the task groups
+  std::mutex mutex_;
+
+  /// signals the workers that there are tasks (or that we are stopping)
+  std::condition_variable available_;
+
+  /// signals waiting groups that a task finished or a new task was queued
+  std::condition_variable changed_;
+
+  /// are we shutting down?
+  bool stop_{false};
+
+  /// the worker threads
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace framework
+
+#endif  // FRAMEWORK_THREADPOOL_H_
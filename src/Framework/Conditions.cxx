@@ -1,5 +1,6 @@
 #include "Framework/Conditions.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include "Framework/PluginFactory.h"
@@ -7,8 +8,30 @@
 
 namespace framework {
 
+thread_local std::vector<Conditions::CacheEntry*> Conditions::pinned_;
+thread_local const ldmx::EventHeader* Conditions::context_{nullptr};
+
+namespace {
+/// Number of threads that asked for a bit to mark their pinned entries
+std::atomic<unsigned int> n_thread_bits{0};
+}  // namespace
+
 Conditions::Conditions(Process& p) : process_{p} {}
 
+Conditions::~Conditions() {
+  if (prefetch_.valid()) prefetch_.wait();
+}
+
+void Conditions::setCacheDepth(int depth) {
+  if (depth < 1) {
+    EXCEPTION_RAISE("ConditionsException",
+                    "The conditions cache needs to keep at least one version "
+                    "of each condition, not " +
+                        std::to_string(depth) + ".");
+  }
+  cacheDepth_ = depth;
+}
+
 void Conditions::createConditionsObjectProvider(
     const std::string& classname, const std::string& objname,
     const std::string& tagname, const framework::config::Parameters& params) {
@@ -26,90 +49,263 @@ void Conditions::createConditionsObjectProvider(
               provides);
     }
     providerMap_[provides] = cop;
+    slots_[provides].provider = cop;
   } else {
     EXCEPTION_RAISE("ConditionsException",
                     "No ConditionsObjectProvider for " + classname);
   }
 }
 
+void Conditions::setDiskCache(const std::string& directory) {
+  diskCache_ = std::make_unique<ConditionsDiskCache>(directory);
+}
+
+void Conditions::require(const std::string& condition_name) {
+  if (std::find(required_.begin(), required_.end(), condition_name) ==
+      required_.end())
+    required_.push_back(condition_name);
+}
+
 void Conditions::onProcessStart() {
+  for (const auto& name : required_) {
+    if (slots_.find(name) == slots_.end()) {
+      EXCEPTION_RAISE("ConditionUnavailable",
+                      "No provider is available for the required condition " +
+                          name);
+    }
+  }
   for (auto ptr : providerMap_) ptr.second->onProcessStart();
 }
 
 void Conditions::onProcessEnd() {
+  waitForPrefetch();
   for (auto ptr : providerMap_) ptr.second->onProcessEnd();
 }
 
 void Conditions::onNewRun(ldmx::RunHeader& rh) {
+  waitForPrefetch();
+  invalidate();
   for (auto ptr : providerMap_) ptr.second->onNewRun(rh);
+  for (const auto& name : required_) getConditionPtr(name);
+}
+
+void Conditions::prefetch(int run) {
+  if (not prefetchNextRun_ or required_.empty()) return;
+  waitForPrefetch();
+  ldmx::EventHeader header{*process_.getEventHeader()};
+  header.setRun(run);
+  prefetch_ = std::async(std::launch::async, [this, header]() {
+    context_ = &header;
+    for (const auto& name : required_) {
+      // versions for the next run don't replace the ones being used
+      load(slots_.at(name), name, header, false);
+    }
+    onEndOfEvent();
+    context_ = nullptr;
+  });
+}
+
+void Conditions::waitForPrefetch() {
+  if (not prefetch_.valid()) return;
+  try {
+    prefetch_.get();
+  } catch (const std::exception& e) {
+    // this will be reported again if the run is actually processed
+    ldmx_log(warn) << "Unable to prefetch conditions: " << e.what();
+  }
+}
+
+void Conditions::releaseSince(std::size_t mark) {
+  std::uint64_t bit{threadBit()};
+  for (std::size_t i{mark}; i < pinned_.size(); i++) {
+    // unmark before unpinning, the entry may be reused once released
+    pinned_[i]->pinnedBy.fetch_and(~bit);
+    unpin(pinned_[i]);
+  }
+  if (mark < pinned_.size()) pinned_.resize(mark);
 }
 
 ConditionsIOV Conditions::getConditionIOV(
     const std::string& condition_name) const {
-  auto cacheptr = cache_.find(condition_name);
-  if (cacheptr == cache_.end())
+  auto slotptr = slots_.find(condition_name);
+  if (slotptr == slots_.end()) return ConditionsIOV();
+  const Slot& slot{slotptr->second};
+  // the version most recently requested by this thread
+  for (auto it = pinned_.rbegin(); it != pinned_.rend(); it++) {
+    if ((*it)->slot == &slot) return (*it)->iov;
+  }
+  std::lock_guard<std::mutex> lock(slot.mutex);
+  CacheEntry* current{slot.current.load()};
+  if (current == nullptr)
     return ConditionsIOV();
   else
-    return cacheptr->second.iov;
+    return current->iov;
 }
 
 const ConditionsObject* Conditions::getConditionPtr(
     const std::string& condition_name) {
-  const ldmx::EventHeader& context = *(process_.getEventHeader());
-  auto cacheptr = cache_.find(condition_name);
+  const ldmx::EventHeader& context =
+      context_ ? *context_ : *(process_.getEventHeader());
+  auto slotptr = slots_.find(condition_name);
 
-  if (cacheptr == cache_.end()) {
-    auto copptr = providerMap_.find(condition_name);
+  if (slotptr == slots_.end()) {
+    EXCEPTION_RAISE(
+        "ConditionUnavailable",
+        std::string("No provider is available for : " + condition_name));
+  }
+  Slot& slot{slotptr->second};
 
-    if (copptr == providerMap_.end()) {
-      EXCEPTION_RAISE(
-          "ConditionUnavailable",
-          std::string("No provider is available for : " + condition_name));
+  CacheEntry* entry{slot.current.load()};
+  if (entry) {
+    if (isPinned(entry)) {
+      // we already use this entry, so it can't change under us
+      if (entry->iov.validForEvent(context)) return entry->obj;
+    } else {
+      // pin before checking the entry so that it isn't reused while we
+      // look at it, if it is still current after pinning it is safe to use
+      entry->pins++;
+      if (slot.current.load() == entry and
+          entry->iov.validForEvent(context)) {
+        track(entry);
+        return entry->obj;
+      }
+      unpin(entry);
     }
+  }
 
-    std::pair<const ConditionsObject*, ConditionsIOV> cond =
-        copptr->second->getCondition(context);
+  return load(slot, condition_name, context)->obj;
+}
+
+Conditions::CacheEntry* Conditions::load(Slot& slot, const std::string& name,
+                                         const ldmx::EventHeader& context,
+                                         bool make_current) {
+  std::lock_guard<std::mutex> lock(slot.mutex);
 
+  // another thread may have loaded it while we waited,
+  // or we may still have a version valid for this event
+  CacheEntry* found{nullptr};
+  CacheEntry* current{slot.current.load()};
+  if (current and current->iov.validForEvent(context)) {
+    found = current;
+  } else {
+    for (auto& entry : slot.entries) {
+      if (entry->obj and entry->iov.validForEvent(context)) {
+        found = entry.get();
+        break;
+      }
+    }
+  }
+
+  if (found == nullptr) {
+    std::pair<const ConditionsObject*, ConditionsIOV> cond{nullptr,
+                                                           ConditionsIOV()};
+    if (diskCache_) cond = diskCache_->get(name, *slot.provider, context);
     if (!cond.first) {
-      EXCEPTION_RAISE(
-          "ConditionUnavailable",
-          std::string("Null condition returned for requested item : " +
-                      condition_name));
+      cond = slot.provider->getCondition(context);
+      if (cond.first and diskCache_)
+        diskCache_->put(name, *slot.provider, cond.first, cond.second);
     }
 
-    // first request, create a cache entry
-    CacheEntry ce;
-    ce.iov = cond.second;
-    ce.obj = cond.first;
-    ce.provider = copptr->second;
-    cache_[condition_name] = ce;
-    return ce.obj;
-  } else {
-    /// if still valid, we return what we have
-    if (cacheptr->second.iov.validForEvent(context))
-      return cacheptr->second.obj;
-    else {
-      // if not, we release the old object
-      cacheptr->second.provider->releaseConditionsObject(cacheptr->second.obj);
-      // now ask for a new one
-      std::pair<const ConditionsObject*, ConditionsIOV> cond =
-          cacheptr->second.provider->getCondition(context);
-
-      if (!cond.first) {
-        std::stringstream s;
-        s << "Unable to update condition '" << condition_name << "' for event "
-          << context.getEventNumber() << " run " << context.getRun();
-        if (context.isRealData())
-          s << " DATA";
-        else
-          s << " MC";
-        EXCEPTION_RAISE("ConditionUnavailable", s.str());
+    if (!cond.first) {
+      std::stringstream s;
+      s << "Unable to provide condition '" << name << "' for event "
+        << context.getEventNumber() << " run " << context.getRun();
+      if (context.isRealData())
+        s << " DATA";
+      else
+        s << " MC";
+      EXCEPTION_RAISE("ConditionUnavailable", s.str());
+    }
+
+    // reuse an entry whose object has been released
+    for (auto& entry : slot.entries) {
+      if (entry->obj == nullptr and entry->pins.load() == 0) {
+        found = entry.get();
+        break;
       }
-      cacheptr->second.iov = cond.second;
-      cacheptr->second.obj = cond.first;
-      return cond.first;
+    }
+    if (found == nullptr) {
+      slot.entries.push_back(std::make_unique<CacheEntry>());
+      found = slot.entries.back().get();
+      found->slot = &slot;
+    }
+    found->iov = cond.second;
+    found->obj = cond.first;
+  }
+
+  found->retired = false;
+  if (found != current) {
+    found->lastCurrent = ++slot.counter;
+    if (make_current or current == nullptr) {
+      slot.current = found;
+      invalidate();
     }
   }
+  pin(found);
+  trim(slot);
+  return found;
+}
+
+void Conditions::trim(Slot& slot) {
+  std::size_t n_live{0};
+  for (auto& entry : slot.entries) {
+    if (entry->obj and not entry->retired) n_live++;
+  }
+
+  while (n_live > cacheDepth_) {
+    // retire the version that has been current the longest time ago
+    CacheEntry* oldest{nullptr};
+    CacheEntry* current{slot.current.load()};
+    for (auto& entry : slot.entries) {
+      if (entry->obj and not entry->retired and entry.get() != current and
+          (oldest == nullptr or entry->lastCurrent < oldest->lastCurrent))
+        oldest = entry.get();
+    }
+    // mark it before checking the pins, so that either we see that it
+    // isn't pinned anymore or the last one to unpin it sees it is retired
+    oldest->retired = true;
+    if (oldest->pins.load() == 0) release(*oldest);
+    n_live--;
+  }
+}
+
+void Conditions::release(CacheEntry& entry) {
+  entry.slot->provider->releaseConditionsObject(entry.obj);
+  entry.obj = nullptr;
+  entry.retired = false;
+}
+
+void Conditions::pin(CacheEntry* entry) {
+  if (isPinned(entry)) return;
+  entry->pins++;
+  track(entry);
+}
+
+void Conditions::unpin(CacheEntry* entry) {
+  if (entry->pins.fetch_sub(1) == 1 and entry->retired.load()) {
+    std::lock_guard<std::mutex> lock(entry->slot->mutex);
+    if (entry->pins.load() == 0 and entry->retired.load() and entry->obj)
+      release(*entry);
+  }
+}
+
+std::uint64_t Conditions::threadBit() {
+  static thread_local const std::uint64_t bit{[]() -> std::uint64_t {
+    unsigned int i_thread{n_thread_bits++};
+    return i_thread < 64 ? std::uint64_t{1} << i_thread : 0;
+  }()};
+  return bit;
+}
+
+bool Conditions::isPinned(const CacheEntry* entry) {
+  std::uint64_t bit{threadBit()};
+  if (bit != 0) return (entry->pinnedBy.load() & bit) != 0;
+  return std::find(pinned_.begin(), pinned_.end(), entry) != pinned_.end();
+}
+
+void Conditions::track(CacheEntry* entry) {
+  entry->pinnedBy.fetch_or(threadBit());
+  pinned_.push_back(entry);
 }
 
 }  // namespace framework
@@ -0,0 +1,176 @@
+#include "Framework/ConditionsDiskCache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "Framework/ConditionsObjectProvider.h"
+#include "Framework/ConfigCache.h"
+#include "Framework/EventHeader.h"
+#include "TSystem.h"
+
+namespace framework {
+
+/// marks the beginning and end of a cache file (and its version)
+static const char CACHE_MAGIC[8] = {'L', 'D', 'M', 'X', 'C', 'D', 'C', '1'};
+
+/// extension of the cache files
+static const std::string CACHE_EXTENSION{".cond"};
+
+ConditionsDiskCache::ConditionsDiskCache(const std::string &directory)
+    : directory_{directory} {}
+
+std::pair<const ConditionsObject *, ConditionsIOV> ConditionsDiskCache::get(
+    const std::string &name, const ConditionsObjectProvider &provider,
+    const ldmx::EventHeader &context) const {
+  std::string dir_path{directory(name, provider)};
+  if (dir_path.empty()) return std::make_pair(nullptr, ConditionsIOV());
+  DIR *dir = opendir(dir_path.c_str());
+  if (not dir) return std::make_pair(nullptr, ConditionsIOV());
+
+  std::string found;
+  ConditionsIOV iov;
+  while (struct dirent *entry = readdir(dir)) {
+    std::string file{entry->d_name};
+    if (file.size() <= CACHE_EXTENSION.size() or
+        file.compare(file.size() - CACHE_EXTENSION.size(),
+                     CACHE_EXTENSION.size(), CACHE_EXTENSION) != 0)
+      continue;
+    int first, last, data, mc;
+    if (std::sscanf(file.c_str(), "%d_%d_%1d%1d", &first, &last, &data, &mc) !=
+        4)
+      continue;
+    ConditionsIOV candidate(first, last, data == 1, mc == 1);
+    if (candidate.validForEvent(context)) {
+      found = dir_path + "/" + file;
+      iov = candidate;
+      break;
+    }
+  }
+  closedir(dir);
+
+  if (found.empty()) return std::make_pair(nullptr, ConditionsIOV());
+  const ConditionsObject *obj{read(found, provider)};
+  if (obj) {
+    ldmx_log(debug) << "Read " << name << " " << iov.ToString() << " from '"
+                    << found << "'";
+  }
+  return std::make_pair(obj, iov);
+}
+
+void ConditionsDiskCache::put(const std::string &name,
+                              const ConditionsObjectProvider &provider,
+                              const ConditionsObject *obj,
+                              const ConditionsIOV &iov) const {
+  std::string dir_path{directory(name, provider)};
+  if (dir_path.empty()) return;
+
+  std::string serialized;
+  if (not provider.writeConditionsObject(obj, serialized)) {
+    ldmx_log(debug) << "Condition " << name << " can't be cached on disk";
+    return;
+  }
+
+  gSystem->mkdir(dir_path.c_str(), true);
+  std::string path{dir_path + "/" + std::to_string(iov.getFirstRun()) + "_" +
+                   std::to_string(iov.getLastRun()) + "_" +
+                   (iov.isValidForData() ? "1" : "0") +
+                   (iov.isValidForMC() ? "1" : "0") + CACHE_EXTENSION};
+
+  // other jobs may be reading the cache right now, so we only
+  // put a complete file into place
+  std::string tmp{path + ".tmp" + std::to_string(getpid())};
+  std::ofstream out(tmp, std::ios::binary);
+  std::uint64_t size{serialized.size()};
+  out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+  out.write(serialized.data(), serialized.size());
+  out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  out.close();
+
+  if (not out or std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    ldmx_log(warn) << "Unable to write condition " << name
+                   << " into the cache '" << path << "'.";
+    return;
+  }
+  ldmx_log(debug) << "Wrote " << name << " " << iov.ToString() << " to '"
+                  << path << "'";
+}
+
+std::string ConditionsDiskCache::directory(
+    const std::string &name, const ConditionsObjectProvider &provider) const {
+  if (not provider.allowsDiskCache()) return "";
+
+  std::string hash;
+  {
+    std::lock_guard<std::mutex> lock(hashesMutex_);
+    auto known{hashes_.find(&provider)};
+    if (known != hashes_.end()) {
+      hash = known->second;
+    } else {
+      try {
+        char digits[17];
+        std::snprintf(digits, sizeof(digits), "%016llx",
+                      static_cast<unsigned long long>(
+                          config::hashParameters(provider.getParameters())));
+        hash = digits;
+      } catch (const framework::exception::Exception &e) {
+        ldmx_log(warn) << "Not caching the conditions of provider '"
+                       << provider.getConditionObjectName()
+                       << "', its parameters can't be hashed: "
+                       << e.message();
+      }
+      hashes_[&provider] = hash;
+    }
+  }
+  if (hash.empty()) return "";
+  return directory_ + "/" + name + "/" + provider.getTagName() + "/" + hash;
+}
+
+const ConditionsObject *ConditionsDiskCache::read(
+    const std::string &path, const ConditionsObjectProvider &provider) const {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return nullptr;
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  std::size_t size = info.st_size;
+  if (size < 2 * sizeof(CACHE_MAGIC) + sizeof(std::uint64_t)) {
+    ::close(fd);
+    return nullptr;
+  }
+  void *mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) return nullptr;
+
+  const char *begin{static_cast<const char *>(mapped)};
+  std::uint64_t length;
+  std::memcpy(&length, begin + sizeof(CACHE_MAGIC), sizeof(length));
+  const ConditionsObject *obj{nullptr};
+  if (std::memcmp(begin, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 and
+      std::memcmp(begin + size - sizeof(CACHE_MAGIC), CACHE_MAGIC,
+                  sizeof(CACHE_MAGIC)) == 0 and
+      length == size - 2 * sizeof(CACHE_MAGIC) - sizeof(length)) {
+    obj = provider.readConditionsObject(
+        begin + sizeof(CACHE_MAGIC) + sizeof(length), length);
+  }
+  munmap(mapped, size);
+
+  if (not obj) {
+    ldmx_log(warn) << "Conditions cache file '" << path
+                   << "' is not valid, ignoring it.";
+  }
+  return obj;
+}
+
+}  // namespace framework
@@ -1,9 +1,16 @@
 #include "Framework/ConditionsObjectProvider.h"
 
+#include <cstdint>
+#include <cstring>
+
 // LDMX
 #include "Framework/PluginFactory.h"
 #include "Framework/Process.h"
 
+// ROOT
+#include "TBufferFile.h"
+#include "TClass.h"
+
 namespace framework {
 
 ConditionsObjectProvider::ConditionsObjectProvider(
@@ -12,6 +19,7 @@ ConditionsObjectProvider::ConditionsObjectProvider(
     : process_{process},
       objectName_{objname},
       tagname_{tagname},
+      parameters_{params},
       theLog_{logging::makeLogger(objname)} {}
 
 std::pair<const ConditionsObject*, ConditionsIOV>
@@ -22,6 +30,53 @@ ConditionsObjectProvider::requestParentCondition(
   return std::make_pair(obj, iov);
 }
 
+bool ConditionsObjectProvider::writeConditionsObject(
+    const ConditionsObject* co, std::string& buffer) const {
+  TClass* cls{TClass::GetClass(typeid(*co))};
+  if (not cls or not cls->HasDictionary() or not cls->HasDefaultConstructor())
+    return false;
+
+  // the full object, and the offset of the ConditionsObject inside of it
+  // so that we can find it again in the object ROOT creates when reading
+  const void* full{dynamic_cast<const void*>(co)};
+  std::int64_t offset{reinterpret_cast<const char*>(co) -
+                      static_cast<const char*>(full)};
+
+  TBufferFile payload(TBuffer::kWrite);
+  cls->Streamer(const_cast<void*>(full), payload);
+
+  std::string class_name{cls->GetName()};
+  std::uint32_t length = class_name.size();
+  buffer.append(reinterpret_cast<const char*>(&length), sizeof(length));
+  buffer.append(class_name);
+  buffer.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+  buffer.append(payload.Buffer(), payload.Length());
+  return true;
+}
+
+const ConditionsObject* ConditionsObjectProvider::readConditionsObject(
+    const char* buffer, std::size_t size) const {
+  std::uint32_t length;
+  std::int64_t offset;
+  if (size < sizeof(length)) return nullptr;
+  std::memcpy(&length, buffer, sizeof(length));
+  std::size_t start{sizeof(length) + length + sizeof(offset)};
+  if (size < start) return nullptr;
+  std::string class_name(buffer + sizeof(length), length);
+  std::memcpy(&offset, buffer + sizeof(length) + length, sizeof(offset));
+
+  TClass* cls{TClass::GetClass(class_name.c_str())};
+  if (not cls or not cls->HasDictionary()) return nullptr;
+  void* obj{cls->New()};
+  if (not obj) return nullptr;
+  // the buffer does not own (or write to) the cached data
+  TBufferFile payload(TBuffer::kRead, size - start,
+                      const_cast<char*>(buffer + start), false);
+  cls->Streamer(obj, payload);
+  return reinterpret_cast<const ConditionsObject*>(static_cast<char*>(obj) +
+                                                   offset);
+}
+
 void ConditionsObjectProvider::declare(const std::string& classname,
                                        ConditionsObjectProviderMaker* maker) {
   PluginFactory::getInstance().registerConditionsObjectProvider(
@@ -0,0 +1,289 @@
+#include "Framework/ConfigCache.h"
+
+/*~~~~~~~~~~~~~~~~*/
+/*   C++ StdLib   */
+/*~~~~~~~~~~~~~~~~*/
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+namespace framework {
+namespace config {
+
+namespace {
+
+/// first bytes of a cache file, changed whenever the format changes
+const std::string MAGIC{"LDMXCFG1"};
+
+/**
+ * Types of parameters we can write
+ *
+ * These are the types ConfigurePython creates from python.
+ */
+enum class Tag : uint8_t {
+  Int,
+  Bool,
+  Double,
+  String,
+  Params,
+  VecInt,
+  VecDouble,
+  VecString,
+  VecParams,
+  VecVecInt,
+  VecVecDouble,
+  VecVecString,
+  VecVecParams
+};
+
+/**
+ * Update an FNV-1a hash with some bytes
+ */
+void hashBytes(uint64_t& hash, const char* data, std::size_t size) {
+  for (std::size_t i{0}; i < size; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 0x100000001B3;
+  }
+}
+
+template <typename T>
+void writeRaw(std::ostream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readRaw(std::istream& in) {
+  T value;
+  if (not in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+    EXCEPTION_RAISE("ConfigCache", "The configuration cache ended early.");
+  }
+  return value;
+}
+
+void write(std::ostream& out, int value) { writeRaw<int32_t>(out, value); }
+void write(std::ostream& out, bool value) { writeRaw<uint8_t>(out, value); }
+void write(std::ostream& out, double value) { writeRaw(out, value); }
+void write(std::ostream& out, const std::string& value) {
+  writeRaw<uint32_t>(out, value.size());
+  out.write(value.data(), value.size());
+}
+void write(std::ostream& out, const Parameters& value) {
+  writeParameters(out, value);
+}
+template <typename T>
+void write(std::ostream& out, const std::vector<T>& values) {
+  writeRaw<uint32_t>(out, values.size());
+  for (const auto& value : values) write(out, value);
+}
+
+template <typename T>
+T read(std::istream& in);
+template <>
+int read<int>(std::istream& in) {
+  return readRaw<int32_t>(in);
+}
+template <>
+bool read<bool>(std::istream& in) {
+  return readRaw<uint8_t>(in);
+}
+template <>
+double read<double>(std::istream& in) {
+  return readRaw<double>(in);
+}
+template <>
+std::string read<std::string>(std::istream& in) {
+  std::string value(readRaw<uint32_t>(in), '\0');
+  if (not in.read(value.data(), value.size())) {
+    EXCEPTION_RAISE("ConfigCache", "The configuration cache ended early.");
+  }
+  return value;
+}
+template <>
+Parameters read<Parameters>(std::istream& in) {
+  return readParameters(in);
+}
+
+/**
+ * Read a vector, the element type has to be given explicitly
+ */
+template <typename T>
+std::vector<T> readVector(std::istream& in) {
+  std::vector<T> values(readRaw<uint32_t>(in));
+  for (auto& value : values) value = read<T>(in);
+  return values;
+}
+
+template <typename T>
+std::vector<std::vector<T>> readVectorVector(std::istream& in) {
+  std::vector<std::vector<T>> values(readRaw<uint32_t>(in));
+  for (auto& value : values) value = readVector<T>(in);
+  return values;
+}
+
+/**
+ * Write a value if it is held with the input type
+ *
+ * @return true if the value was of the input type and written
+ */
+template <typename T>
+bool writeIf(std::ostream& out, Tag tag, const std::any& value) {
+  if (value.type() != typeid(T)) return false;
+  writeRaw(out, tag);
+  write(out, std::any_cast<const T&>(value));
+  return true;
+}
+
+}  // namespace
+
+uint64_t hashSource(const std::string& pythonScript, char* args[], int nargs) {
+  std::ifstream script(pythonScript, std::ios::binary);
+  if (not script) {
+    EXCEPTION_RAISE("ConfigDNE", "Passed config script '" + pythonScript +
+                                     "' is not accessible.");
+  }
+  std::string contents{std::istreambuf_iterator<char>(script),
+                       std::istreambuf_iterator<char>()};
+  uint64_t hash{0xCBF29CE484222325};
+  hashBytes(hash, contents.data(), contents.size());
+  for (int i{0}; i < nargs; i++) {
+    // include the terminating null so the arguments can't run together
+    hashBytes(hash, args[i], std::strlen(args[i]) + 1);
+  }
+  return hash;
+}
+
+uint64_t hashParameters(const Parameters& parameters) {
+  std::ostringstream out;
+  writeParameters(out, parameters);
+  std::string bytes{out.str()};
+  uint64_t hash{0xCBF29CE484222325};
+  hashBytes(hash, bytes.data(), bytes.size());
+  return hash;
+}
+
+void writeParameters(std::ostream& out, const Parameters& parameters) {
+  const auto& values{parameters.getParameters()};
+  writeRaw<uint32_t>(out, values.size());
+  for (const auto& [name, value] : values) {
+    write(out, name);
+    bool written{
+        writeIf<int>(out, Tag::Int, value) or
+        writeIf<bool>(out, Tag::Bool, value) or
+        writeIf<double>(out, Tag::Double, value) or
+        writeIf<std::string>(out, Tag::String, value) or
+        writeIf<Parameters>(out, Tag::Params, value) or
+        writeIf<std::vector<int>>(out, Tag::VecInt, value) or
+        writeIf<std::vector<double>>(out, Tag::VecDouble, value) or
+        writeIf<std::vector<std::string>>(out, Tag::VecString, value) or
+        writeIf<std::vector<Parameters>>(out, Tag::VecParams, value) or
+        writeIf<std::vector<std::vector<int>>>(out, Tag::VecVecInt, value) or
+        writeIf<std::vector<std::vector<double>>>(out, Tag::VecVecDouble,
+                                                  value) or
+        writeIf<std::vector<std::vector<std::string>>>(out, Tag::VecVecString,
+                                                       value) or
+        writeIf<std::vector<std::vector<Parameters>>>(out, Tag::VecVecParams,
+                                                      value)};
+    if (not written) {
+      EXCEPTION_RAISE("ConfigCache", "Parameter '" + name + "' of type '" +
+                                         value.type().name() +
+                                         "' can't be written to the cache.");
+    }
+  }
+}
+
+Parameters readParameters(std::istream& in) {
+  std::map<std::string, std::any> values;
+  for (uint32_t n{readRaw<uint32_t>(in)}; n > 0; n--) {
+    auto name{read<std::string>(in)};
+    switch (readRaw<Tag>(in)) {
+      case Tag::Int:
+        values[name] = read<int>(in);
+        break;
+      case Tag::Bool:
+        values[name] = read<bool>(in);
+        break;
+      case Tag::Double:
+        values[name] = read<double>(in);
+        break;
+      case Tag::String:
+        values[name] = read<std::string>(in);
+        break;
+      case Tag::Params:
+        values[name] = read<Parameters>(in);
+        break;
+      case Tag::VecInt:
+        values[name] = readVector<int>(in);
+        break;
+      case Tag::VecDouble:
+        values[name] = readVector<double>(in);
+        break;
+      case Tag::VecString:
+        values[name] = readVector<std::string>(in);
+        break;
+      case Tag::VecParams:
+        values[name] = readVector<Parameters>(in);
+        break;
+      case Tag::VecVecInt:
+        values[name] = readVectorVector<int>(in);
+        break;
+      case Tag::VecVecDouble:
+        values[name] = readVectorVector<double>(in);
+        break;
+      case Tag::VecVecString:
+        values[name] = readVectorVector<std::string>(in);
+        break;
+      case Tag::VecVecParams:
+        values[name] = readVectorVector<Parameters>(in);
+        break;
+      default:
+        EXCEPTION_RAISE("ConfigCache", "Parameter '" + name +
+                                           "' has an unknown type in the "
+                                           "configuration cache.");
+    }
+  }
+  Parameters parameters;
+  parameters.setParameters(values);
+  return parameters;
+}
+
+bool readCache(const std::string& cacheFile, uint64_t hash,
+               Parameters& configuration) {
+  std::ifstream in(cacheFile, std::ios::binary);
+  if (not in) return false;
+  std::string magic(MAGIC.size(), '\0');
+  if (not in.read(magic.data(), magic.size()) or magic != MAGIC) return false;
+  uint64_t cached_hash{0};
+  if (not in.read(reinterpret_cast<char*>(&cached_hash), sizeof(cached_hash)) or
+      cached_hash != hash)
+    return false;
+  configuration = readParameters(in);
+  return true;
+}
+
+void writeCache(const std::string& cacheFile, uint64_t hash,
+                const Parameters& configuration) {
+  std::string tmp{cacheFile + ".tmp" + std::to_string(getpid())};
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(MAGIC.data(), MAGIC.size());
+    writeRaw(out, hash);
+    writeParameters(out, configuration);
+    if (not out) {
+      EXCEPTION_RAISE("ConfigCache", "Unable to write the configuration "
+                                     "cache '" + cacheFile + "'.");
+    }
+  }
+  if (std::rename(tmp.c_str(), cacheFile.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    EXCEPTION_RAISE("ConfigCache", "Unable to move the configuration cache "
+                                   "into '" + cacheFile + "'.");
+  }
+}
+
+}  // namespace config
+}  // namespace framework
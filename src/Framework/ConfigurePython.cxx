@@ -6,13 +6,21 @@
 /*~~~~~~~~~~~~*/
 #include "Python.h"
 
+/*~~~~~~~~~~~~~~~*/
+/*   Framework   */
+/*~~~~~~~~~~~~~~~*/
+#include "Framework/ConfigCache.h"
+
 /*~~~~~~~~~~~~~~~~*/
 /*   C++ StdLib   */
 /*~~~~~~~~~~~~~~~~*/
 #include <any>
 #include <cstring>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace framework {
@@ -103,6 +111,164 @@ PyObject* extractDictionary(PyObject* obj) {
 #endif
 }
 
+/**
+ * Check if an item of a buffer can be stored without changing its value
+ *
+ * Only integers can fall out of range, floating point items are
+ * always stored as doubles.
+ *
+ * @param T type of item in the vector
+ * @param S type of item in the buffer
+ * @param[in] item item of the buffer
+ * @return true if the item is in the range of T
+ */
+template <typename T, typename S>
+static bool fits(S item) {
+  if constexpr (not std::is_integral_v<S> or not std::is_integral_v<T>) {
+    return true;
+  } else if constexpr (std::is_unsigned_v<S>) {
+    static_assert(std::is_signed_v<T>, "only signed integers are stored");
+    return item <= static_cast<std::make_unsigned_t<T>>(
+                       std::numeric_limits<T>::max());
+  } else {
+    return item >= std::numeric_limits<T>::min() and
+           item <= std::numeric_limits<T>::max();
+  }
+}
+
+/**
+ * Copy the items of a contiguous buffer into a vector
+ *
+ * If the buffer holds the same type as the vector, this is a single
+ * memcpy, otherwise each item is converted.
+ *
+ * @throws std::out_of_range if an item doesn't fit into the vector
+ *
+ * @param T type of item in the vector
+ * @param S type of item in the buffer
+ * @param[in] buf pointer to the first item in the buffer
+ * @param[in] n number of items to copy
+ * @return vector holding the items
+ */
+template <typename T, typename S>
+static std::vector<T> copyItems(const char* buf, std::size_t n) {
+  std::vector<T> vals(n);
+  if constexpr (std::is_same_v<T, S>) {
+    if (n > 0) std::memcpy(vals.data(), buf, n * sizeof(T));
+  } else {
+    const S* items{reinterpret_cast<const S*>(buf)};
+    for (std::size_t i{0}; i < n; i++) {
+      if (not fits<T>(items[i])) {
+        throw std::out_of_range("item " + std::to_string(items[i]) +
+                                " does not fit into an int");
+      }
+      vals[i] = static_cast<T>(items[i]);
+    }
+  }
+  return vals;
+}
+
+/**
+ * Copy a one or two dimensional buffer into a (nested) vector
+ *
+ * @param T type of item in the vector
+ * @param S type of item in the buffer
+ * @param[in] view buffer to copy, assumed to be C contiguous
+ * @return vector or vector of vectors holding the items
+ */
+template <typename T, typename S>
+static std::any copyBuffer(const Py_buffer& view) {
+  const char* buf{static_cast<const char*>(view.buf)};
+  if (view.ndim == 1) return copyItems<T, S>(buf, view.shape[0]);
+  std::vector<std::vector<T>> vals;
+  vals.reserve(view.shape[0]);
+  for (Py_ssize_t i{0}; i < view.shape[0]; i++) {
+    vals.push_back(copyItems<T, S>(buf, view.shape[1]));
+    buf += view.strides[0];
+  }
+  return vals;
+}
+
+/**
+ * Translate a python object supporting the buffer protocol
+ *
+ * This is how numpy arrays and array.array are given to us. Instead
+ * of going through the object item by item like a list, we ask for its
+ * memory and copy it over, in one memcpy if the item type of the buffer
+ * matches what we store. Floating point buffers become vectors of doubles
+ * and integer buffers become vectors of ints, two dimensional buffers
+ * become vectors of vectors.
+ *
+ * Integers that don't fit into an int are reported as a python
+ * ValueError rather than being silently narrowed.
+ *
+ * @throws Exception if the buffer isn't contiguous, has more than two
+ * dimensions, doesn't hold numbers, or holds integers out of range
+ *
+ * @param[in] name name of parameter for error messages
+ * @param[in] object python object supporting the buffer protocol
+ * @return vector (of vectors) holding a copy of the buffer
+ */
+static std::any getBuffer(const std::string& name, PyObject* object) {
+  Py_buffer view;
+  if (PyObject_GetBuffer(object, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) !=
+      0) {
+    PyErr_Clear();
+    EXCEPTION_RAISE("BadConf", "Parameter '" + name +
+                                   "' is an array that isn't C contiguous. "
+                                   "Copy it with numpy.ascontiguousarray.");
+  }
+
+  // only native byte order and alignment is supported
+  const char* format{view.format ? view.format : "B"};
+  if (*format == '@' or *format == '=') format++;
+  if (view.ndim < 1 or view.ndim > 2 or std::strlen(format) != 1) {
+    std::string fmt{view.format ? view.format : "B"};
+    int ndim{view.ndim};
+    PyBuffer_Release(&view);
+    EXCEPTION_RAISE("BadConf", "Parameter '" + name +
+                                   "' is an array of format '" + fmt +
+                                   "' with " + std::to_string(ndim) +
+                                   " dimensions. Only one or two dimensional "
+                                   "arrays of native numbers are supported.");
+  }
+
+  std::any vals;
+  try {
+    switch (*format) {
+      // clang-format off
+      case 'd': vals = copyBuffer<double, double>(view); break;
+      case 'f': vals = copyBuffer<double, float>(view); break;
+      case 'b': vals = copyBuffer<int, signed char>(view); break;
+      case 'B': vals = copyBuffer<int, unsigned char>(view); break;
+      case 'h': vals = copyBuffer<int, short>(view); break;
+      case 'H': vals = copyBuffer<int, unsigned short>(view); break;
+      case 'i': vals = copyBuffer<int, int>(view); break;
+      case 'I': vals = copyBuffer<int, unsigned int>(view); break;
+      case 'l': vals = copyBuffer<int, long>(view); break;
+      case 'L': vals = copyBuffer<int, unsigned long>(view); break;
+      case 'q': vals = copyBuffer<int, long long>(view); break;
+      case 'Q': vals = copyBuffer<int, unsigned long long>(view); break;
+      // clang-format on
+      default: {
+        std::string fmt{view.format};
+        PyBuffer_Release(&view);
+        EXCEPTION_RAISE("BadConf", "Parameter '" + name +
+                                       "' is an array of unsupported format '" +
+                                       fmt + "'.");
+      }
+    }
+  } catch (const std::out_of_range& e) {
+    PyBuffer_Release(&view);
+    std::string msg{"Parameter '" + name + "' has an " + e.what() + "."};
+    PyErr_SetString(PyExc_ValueError, msg.c_str());
+    PyErr_Print();
+    EXCEPTION_RAISE("ValueError", msg);
+  }
+  PyBuffer_Release(&view);
+  return vals;
+}
+
 /**
  * Extract members from a python object.
  *
@@ -130,6 +296,9 @@ PyObject* extractDictionary(PyObject* obj) {
  * parameters that can be empty need to put in a default empty list
  * value: {}.
  *
+ * @note Objects supporting the buffer protocol (e.g. numpy arrays) are
+ * copied over in bulk by getBuffer rather than item by item.
+ *
  * @param object Python object to get members from
  * @return Mapping between member name and value.
  */
@@ -253,6 +422,9 @@ static std::map<std::string, std::any> getMembers(PyObject* object) {
           params[skey] = vals;
         }  // type of object in python list
       }    // python list has non-zero size
+    } else if (PyObject_CheckBuffer(value)) {
+      // numpy arrays, array.array, ...
+      params[skey] = getBuffer(skey, value);
     } else {
       // object got here, so we assume
       // it is a higher level object
@@ -271,7 +443,22 @@ static std::map<std::string, std::any> getMembers(PyObject* object) {
 }
 
 ConfigurePython::ConfigurePython(const std::string& pythonScript, char* args[],
-                                 int nargs) {
+                                 int nargs, const std::string& cacheFile) {
+  if (cacheFile.empty()) {
+    runScript(pythonScript, args, nargs);
+    return;
+  }
+
+  // the cache is only valid for the exact script and arguments it came from
+  uint64_t hash{config::hashSource(pythonScript, args, nargs)};
+  if (config::readCache(cacheFile, hash, configuration_)) return;
+
+  runScript(pythonScript, args, nargs);
+  config::writeCache(cacheFile, hash, configuration_);
+}
+
+void ConfigurePython::runScript(const std::string& pythonScript, char* args[],
+                                int nargs) {
   // assumes that nargs >= 0
   //  this is true always because we error out if no python script has been
   //  found
@@ -4,12 +4,44 @@
 
 namespace framework {
 
+namespace {
+
+/**
+ * Compile a drop rule into a regex
+ *
+ * @throws Exception if the rule is not a valid regex
+ */
+regex_t compileDrop(const std::string& exp) {
+  regex_t reg;
+  if (regcomp(&reg, exp.c_str(), REG_EXTENDED | REG_ICASE | REG_NOSUB)) {
+    EXCEPTION_RAISE("InvalidRegex", "The passed drop rule regex '" + exp +
+                                        "' is not a valid regex.");
+  }
+  return reg;
+}
+
+/**
+ * Check if a branch name matches any of the drop rules
+ */
+bool matchesAny(const std::vector<regex_t>& drops,
+                const std::string& branchName) {
+  for (const regex_t& exp : drops) {
+    if (!regexec(&exp, branchName.c_str(), 0, 0, 0)) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
 Event::Event(const std::string& thePassName) : passName_(thePassName) {}
 
 Event::~Event() {
   for (regex_t& reg : regexDropCollections_) {
     regfree(&reg);
   }
+  for (StreamTree& stream : streamTrees_) {
+    for (regex_t& reg : stream.drops) regfree(&reg);
+  }
 }
 
 void Event::Print() const {
@@ -19,13 +51,13 @@ void Event::Print() const {
 }
 
 void Event::addDrop(const std::string& exp) {
-  regex_t reg;
-  if (!regcomp(&reg, exp.c_str(), REG_EXTENDED | REG_ICASE | REG_NOSUB)) {
-    regexDropCollections_.push_back(reg);
-  } else {
-    EXCEPTION_RAISE("InvalidRegex", "The passed drop rule regex '" + exp +
-                                        "' is not a valid regex.");
-  }
+  regexDropCollections_.push_back(compileDrop(exp));
+}
+
+void Event::addStreamTree(TTree* tree, const std::vector<std::string>& drops) {
+  StreamTree stream{tree, {}};
+  for (const auto& exp : drops) stream.drops.push_back(compileDrop(exp));
+  streamTrees_.push_back(stream);
 }
 
 /**
@@ -67,6 +99,8 @@ std::vector<ProductTag> Event::searchProducts(const std::string& namematch,
                                               const std::string& passmatch,
                                               const std::string& typematch,
                                               bool full_string_match) const {
+  std::unique_lock<std::recursive_mutex> lock(mutex_, std::defer_lock);
+  if (concurrent_) lock.lock();
   std::vector<ProductTag> retval;
   regex_t reg_name{construct_regex(namematch, full_string_match)},
       reg_pass{construct_regex(passmatch, full_string_match)},
@@ -114,7 +148,7 @@ void Event::setInputTree(TTree* tree) {
   // so reset branch listing before starting
   products_.clear();
   knownLookups_.clear();  // reset caching of empty pass requests
-  bus_.everybodyOff();
+  bus_.parkEverybody();
 
   // put in EventHeader (only one without pass name)
   products_.emplace_back(ldmx::EventHeader::BRANCH, "", "ldmx::EventHeader");
@@ -138,14 +172,88 @@ void Event::setInputTree(TTree* tree) {
   }
 }
 
+void Event::setOutputNTuple(RNTupleSink* sink) { outputNTuple_ = sink; }
+
+void Event::setInputNTuple(RNTupleSource* source) {
+  inputNTuple_ = source;
+
+  products_.clear();
+  knownLookups_.clear();
+  bus_.parkEverybody();
+
+  // the field names are the branch names we would have in a TTree
+  for (const auto& [name, type] : inputNTuple_->getFields()) {
+    if (name == ldmx::EventHeader::BRANCH) {
+      products_.emplace_back(name, "", type);
+    } else {
+      size_t j = name.find("_");
+      products_.emplace_back(name.substr(0, j), name.substr(j + 1), type);
+    }
+  }
+}
+
 bool Event::nextEvent() {
   eventHeader_ = getObject<ldmx::EventHeader>(ldmx::EventHeader::BRANCH);
   return true;
 }
 
+void Event::newProduct(const std::string& collectionName,
+                       const std::string& branchName, std::string tname) {
+  if (outputTree_ and not shouldDrop(branchName)) {
+    // we are writing this branch to an output file, so let's
+    //  attach this passenger to the output tree
+    TBranch* outBranch = bus_.attach(outputTree_, branchName, true);
+    // get type name from branch if possible,
+    //  otherwise use compiler level type name
+    std::string class_name{outBranch->GetClassName()};
+    if (not class_name.empty()) tname = class_name;
+  } else if (outputNTuple_ and not shouldDrop(branchName)) {
+    // we are writing to an RNTuple, so add a field for this passenger
+    tname = bus_.typeName(branchName);
+    outputNTuple_->addField(branchName, tname, bus_.address(branchName));
+  }  // output tree exists or not
+
+  // the other output streams decide on their own what to drop
+  for (const StreamTree& stream : streamTrees_) {
+    if (not matchesAny(stream.drops, branchName))
+      bus_.attach(stream.tree, branchName, true);
+  }
+
+  // check for cache entry to remove
+  auto it_known{knownLookups_.find(collectionName)};
+  if (it_known != knownLookups_.end()) knownLookups_.erase(it_known);
+
+  // add us to list of products
+  products_.emplace_back(collectionName, passName_, tname);
+}
+
+void Event::takeProducts(Event& from) {
+  eventHeader_ = from.eventHeader_;
+  electronCount_ = from.electronCount_;
+  for (const auto& [branchName, filled] : from.branchesFilled_) {
+    // the header is put in from our copy before filling
+    if (not filled or branchName == ldmx::EventHeader::BRANCH) continue;
+    if (not bus_.isOnBoard(branchName)) {
+      bus_.boardLike(branchName, from.bus_);
+      newProduct(branchName.substr(0, branchName.find('_')), branchName,
+                 from.bus_.typeName(branchName));
+    }
+    branchesFilled_[branchName] = true;
+    try {
+      bus_.exchange(branchName, from.bus_);
+    } catch (const std::bad_cast&) {
+      EXCEPTION_RAISE("TypeMismatch",
+                      "The product '" + branchName +
+                          "' has a different type than in earlier events.");
+    }
+  }
+  from.Clear();
+}
+
 void Event::beforeFill() {
-  if (inputTree_ == 0 && branchesFilled_.find(ldmx::EventHeader::BRANCH) ==
-                             branchesFilled_.end()) {
+  auto header{branchesFilled_.find(ldmx::EventHeader::BRANCH)};
+  if (inputTree_ == 0 && inputNTuple_ == nullptr &&
+      (header == branchesFilled_.end() or not header->second)) {
     // Event Header not copied from input and hasn't been added yet, need to put
     // it in
     add(ldmx::EventHeader::BRANCH, eventHeader_);
@@ -153,7 +261,8 @@ void Event::beforeFill() {
 }
 
 void Event::Clear() {
-  branchesFilled_.clear();  // forget names of branches we filled
+  // forget which branches we filled, keeping the names for the next event
+  for (auto& [name, filled] : branchesFilled_) filled = false;
   bus_.clear();  // clear the event objects individually but leave them on bus
 }
 
@@ -162,17 +271,17 @@ void Event::onEndOfEvent() {}
 void Event::onEndOfFile() {
   if (outputTree_)
     outputTree_->ResetBranchAddresses();  // reset addresses for output branch
+  for (StreamTree& stream : streamTrees_) stream.tree->ResetBranchAddresses();
   if (inputTree_)
     inputTree_ = nullptr;  // detach old inputTree (owned by EventFile)
+  inputNTuple_ = nullptr;  // same for the RNTuple (also owned by EventFile)
+  inputCache_ = nullptr;   // and the cache
   knownLookups_.clear();   // reset caching of empty pass requests
-  bus_.everybodyOff();     // delete buffer objects
+  bus_.parkEverybody();    // keep buffer objects for the next file
 }
 
 bool Event::shouldDrop(const std::string& branchName) const {
-  for (const regex_t& exp : regexDropCollections_) {
-    if (!regexec(&exp, branchName.c_str(), 0, 0, 0)) return true;
-  }
-  return false;
+  return matchesAny(regexDropCollections_, branchName);
 }
 
 }  // namespace framework
@@ -0,0 +1,310 @@
+#include "Framework/EventCache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <regex>
+#include <sstream>
+
+#include "Framework/Exception/Exception.h"
+#include "TBranchElement.h"
+#include "TBufferFile.h"
+#include "TClass.h"
+#include "TFile.h"
+#include "TLeaf.h"
+#include "TSystem.h"
+#include "TTree.h"
+
+namespace framework {
+
+/// marks the beginning and end of a cache file (and its version)
+static const char CACHE_MAGIC[8] = {'L', 'D', 'M', 'X', 'E', 'V', 'C', '1'};
+
+EventCache::EventCache(TFile *file, TTree *tree, const std::string &directory,
+                       const std::vector<std::string> &collections) {
+  std::vector<std::regex> patterns;
+  for (const auto &collection : collections) {
+    try {
+      patterns.emplace_back(collection);
+    } catch (const std::regex_error &) {
+      EXCEPTION_RAISE("InvalidRegex", "The cached collection pattern '" +
+                                          collection +
+                                          "' is not a valid regex.");
+    }
+  }
+
+  TObjArray *branches = tree->GetListOfBranches();
+  for (int i = 0; i < branches->GetEntriesFast(); i++) {
+    auto br{static_cast<TBranch *>(branches->At(i))};
+    std::string name{br->GetName()};
+    bool selected{false};
+    for (const auto &pattern : patterns) {
+      if (std::regex_match(name, pattern)) {
+        selected = true;
+        break;
+      }
+    }
+    if (not selected) continue;
+
+    Branch branch{name, nullptr, 0};
+    if (auto el = dynamic_cast<TBranchElement *>(br)) {
+      branch.class_ = TClass::GetClass(el->GetClassName());
+      if (not branch.class_) {
+        ldmx_log(warn) << "Unable to find the class '" << el->GetClassName()
+                       << "' of branch '" << name << "', not caching it.";
+        continue;
+      }
+    } else {
+      auto leaf{static_cast<TLeaf *>(br->GetListOfLeaves()->At(0))};
+      branch.size_ = leaf->GetLenType() * leaf->GetLen();
+    }
+    branches_.push_back(branch);
+  }
+
+  if (branches_.empty()) {
+    ldmx_log(warn) << "None of the collections requested for caching are in '"
+                   << file->GetName() << "'.";
+    return;
+  }
+
+  // FNV-1a hash of everything identifying the content of this cache
+  std::uint64_t hash{14695981039346656037ull};
+  auto mix = [&hash](const std::string &s) {
+    for (unsigned char c : s) {
+      hash ^= c;
+      hash *= 1099511628211ull;
+    }
+    // separate consecutive strings
+    hash ^= 0xff;
+    hash *= 1099511628211ull;
+  };
+  mix(file->GetUUID().AsString());
+  mix(std::to_string(file->GetSize()));
+  mix(std::to_string(tree->GetEntries()));
+  for (const auto &branch : branches_) mix(branch.name_);
+
+  std::stringstream path;
+  path << directory << "/" << std::hex << std::setw(16) << std::setfill('0')
+       << hash << ".ldmxcache";
+
+  entries_ = tree->GetEntries();
+  if (not open(path.str(), entries_)) {
+    ldmx_log(info) << "Building event cache '" << path.str() << "' for '"
+                   << file->GetName() << "'.";
+    gSystem->mkdir(directory.c_str(), true);
+    build(tree, path.str());
+    if (not open(path.str(), entries_)) {
+      EXCEPTION_RAISE("EventCache", "Unable to open the event cache '" +
+                                        path.str() + "' after building it.");
+    }
+  } else {
+    ldmx_log(info) << "Using event cache '" << path.str() << "' for '"
+                   << file->GetName() << "'.";
+  }
+}
+
+EventCache::~EventCache() {
+  if (map_) munmap(map_, map_size_);
+}
+
+std::vector<std::string> EventCache::getBranches() const {
+  std::vector<std::string> names;
+  if (not map_) return names;
+  for (const auto &branch : branches_) names.push_back(branch.name_);
+  return names;
+}
+
+bool EventCache::has(const std::string &branch) const {
+  if (not map_) return false;
+  for (const auto &b : branches_) {
+    if (b.name_ == branch) return true;
+  }
+  return false;
+}
+
+void EventCache::connect(const std::string &branch, void *address) {
+  for (std::size_t i{0}; i < branches_.size(); i++) {
+    if (branches_[i].name_ == branch) {
+      connected_.emplace_back(i, address);
+      if (entry_ >= 0) load(i, address);
+      return;
+    }
+  }
+  EXCEPTION_RAISE("ProductNotFound",
+                  "No branch '" + branch + "' in the event cache.");
+}
+
+void EventCache::setEntry(long long entry) {
+  if (entry >= entries_) {
+    EXCEPTION_RAISE("EventCache", "Entry " + std::to_string(entry) +
+                                      " is beyond the end of the cache.");
+  }
+  entry_ = entry;
+  for (auto &[i_branch, address] : connected_) load(i_branch, address);
+}
+
+void EventCache::load(std::size_t i_branch, void *address) const {
+  std::size_t i_obj{entry_ * branches_.size() + i_branch};
+  const char *begin{data_ + index_[i_obj]};
+  std::size_t length{index_[i_obj + 1] - index_[i_obj]};
+  const Branch &branch{branches_[i_branch]};
+  if (branch.class_) {
+    // the buffer does not own (or write to) the mapped memory
+    TBufferFile buffer(TBuffer::kRead, length, const_cast<char *>(begin),
+                       false);
+    branch.class_->Streamer(address, buffer);
+  } else {
+    std::memcpy(address, begin, length);
+  }
+}
+
+void EventCache::build(TTree *tree, const std::string &path) {
+  std::string tmp{path + ".tmp" + std::to_string(getpid())};
+  std::ofstream out(tmp, std::ios::binary);
+  if (not out) {
+    EXCEPTION_RAISE("EventCache",
+                    "Unable to write the event cache '" + tmp + "'.");
+  }
+
+  auto write = [&out](const auto &value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  };
+  auto write_string = [&](const std::string &s) {
+    write(std::uint32_t(s.size()));
+    out.write(s.data(), s.size());
+  };
+
+  out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  write(std::uint64_t(entries_));
+  write(std::uint64_t(branches_.size()));
+  for (const auto &branch : branches_) {
+    write_string(branch.name_);
+    write_string(branch.class_ ? branch.class_->GetName() : "");
+    write(branch.size_);
+  }
+  std::uint64_t data_start = out.tellp();
+
+  // we let ROOT manage the objects it reads the branches into so
+  // that we don't interfere with the Event attaching to this tree later
+  std::vector<TBranch *> tree_branches;
+  for (const auto &branch : branches_)
+    tree_branches.push_back(tree->GetBranch(branch.name_.c_str()));
+
+  std::vector<std::uint64_t> index;
+  index.reserve(entries_ * branches_.size() + 1);
+  TBufferFile buffer(TBuffer::kWrite);
+  for (long long entry{0}; entry < entries_; entry++) {
+    for (std::size_t i{0}; i < branches_.size(); i++) {
+      TBranch *br{tree_branches[i]};
+      br->GetEntry(entry);
+      index.push_back(std::uint64_t(out.tellp()) - data_start);
+      if (branches_[i].class_) {
+        buffer.Reset();
+        branches_[i].class_->Streamer(
+            static_cast<TBranchElement *>(br)->GetObject(), buffer);
+        out.write(buffer.Buffer(), buffer.Length());
+      } else {
+        auto leaf{static_cast<TLeaf *>(br->GetListOfLeaves()->At(0))};
+        out.write(static_cast<const char *>(leaf->GetValuePointer()),
+                  branches_[i].size_);
+      }
+    }
+  }
+  index.push_back(std::uint64_t(out.tellp()) - data_start);
+
+  // align the index so it can be used directly from the mapped memory
+  while (out.tellp() % sizeof(std::uint64_t) != 0) out.put('\0');
+  std::uint64_t index_start = out.tellp();
+  out.write(reinterpret_cast<const char *>(index.data()),
+            index.size() * sizeof(std::uint64_t));
+  write(data_start);
+  write(index_start);
+  out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  out.close();
+
+  if (not out or std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    EXCEPTION_RAISE("EventCache",
+                    "Unable to write the event cache '" + path + "'.");
+  }
+}
+
+bool EventCache::open(const std::string &path, long long entries) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    ::close(fd);
+    return false;
+  }
+  std::size_t size = info.st_size;
+  void *mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) return false;
+
+  const char *begin{static_cast<const char *>(mapped)};
+  std::size_t pos{0};
+  auto read = [&](auto &value) {
+    if (pos + sizeof(value) > size) return false;
+    std::memcpy(&value, begin + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+  };
+  auto read_string = [&](std::string &s) {
+    std::uint32_t length;
+    if (not read(length) or pos + length > size) return false;
+    s.assign(begin + pos, length);
+    pos += length;
+    return true;
+  };
+
+  // check that this cache is complete and has what we expect
+  bool valid{size > 2 * sizeof(CACHE_MAGIC) and
+             std::memcmp(begin, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 and
+             std::memcmp(begin + size - sizeof(CACHE_MAGIC), CACHE_MAGIC,
+                         sizeof(CACHE_MAGIC)) == 0};
+  pos = sizeof(CACHE_MAGIC);
+  std::uint64_t n_entries{0}, n_branches{0};
+  valid = valid and read(n_entries) and read(n_branches) and
+          n_entries == std::uint64_t(entries) and
+          n_branches == branches_.size();
+  for (std::size_t i{0}; valid and i < branches_.size(); i++) {
+    std::string name, class_name;
+    std::uint32_t basic_size;
+    valid = read_string(name) and read_string(class_name) and
+            read(basic_size) and name == branches_[i].name_ and
+            class_name ==
+                (branches_[i].class_ ? branches_[i].class_->GetName() : "") and
+            basic_size == branches_[i].size_;
+  }
+
+  std::uint64_t data_start{0}, index_start{0};
+  if (valid) {
+    pos = size - sizeof(CACHE_MAGIC) - 2 * sizeof(std::uint64_t);
+    std::uint64_t index_size{(n_entries * n_branches + 1) *
+                             sizeof(std::uint64_t)};
+    valid = read(data_start) and read(index_start) and
+            index_start + index_size <= size;
+  }
+
+  if (not valid) {
+    ldmx_log(warn) << "Event cache '" << path
+                   << "' is incomplete or does not match the input file.";
+    munmap(mapped, size);
+    return false;
+  }
+
+  map_ = static_cast<char *>(mapped);
+  map_size_ = size;
+  data_ = map_ + data_start;
+  index_ = reinterpret_cast<const std::uint64_t *>(map_ + index_start);
+  return true;
+}
+
+}  // namespace framework
@@ -1,5 +1,6 @@
 #include <ctime>
 
+#include "TKey.h"
 #include "TTreeReader.h"
 
 // LDMX
@@ -33,6 +34,50 @@ EventFile::EventFile(const framework::config::Parameters &params,
     file_->SetCompressionSettings(
         params.getParameter<int>("compressionSetting", 9));
 
+    auto backend{params.getParameter<std::string>("storageBackend", "TTree")};
+    if (backend == "RNTuple") {
+      if (parent_) {
+        EXCEPTION_RAISE("NotSupported",
+                        "Writing events into an RNTuple is only supported "
+                        "when producing events without input files.");
+      }
+      ntupleSink_ = std::make_unique<RNTupleSink>(
+          file_, "LDMX_Events",
+          params.getParameter<int>("compressionSetting", 9));
+    } else if (backend != "TTree") {
+      EXCEPTION_RAISE("BadConfig", "Unknown storage backend '" + backend +
+                                       "', only 'TTree' and 'RNTuple' "
+                                       "are available.");
+    }
+
+    auto compressionRules{
+        params.getParameter<std::vector<framework::config::Parameters>>(
+            "branchCompressionRules", {})};
+    for (const auto &rule : compressionRules) {
+      auto pattern{rule.getParameter<std::string>("branchPattern")};
+      try {
+        compressionRules_.emplace_back(
+            std::regex(pattern),
+            rule.getParameter<int>("compressionSetting"));
+      } catch (const std::regex_error &) {
+        EXCEPTION_RAISE("InvalidRegex", "The branch compression pattern '" +
+                                            pattern +
+                                            "' is not a valid regex.");
+      }
+    }
+    if (ntupleSink_ and not compressionRules_.empty()) {
+      EXCEPTION_RAISE("NotSupported",
+                      "Per-branch compression rules are not supported when "
+                      "writing events into an RNTuple.");
+    }
+
+    if (parent_ and parent_->ntupleSource_) {
+      EXCEPTION_RAISE("NotSupported",
+                      "Unable to copy events from the RNTuple in '" +
+                          parent_->fileName_ + "' into the output file '" +
+                          fileName_ + "'.");
+    }
+
     if (parent_) {
       // output file when there are input files
       //  might be drop/keep rules, so we should have these rules to make sure
@@ -60,13 +105,24 @@ EventFile::EventFile(const framework::config::Parameters &params,
 
     // Get the tree name from the configuration
     auto tree_name{params.getParameter<std::string>("tree_name")};
-    tree_ = static_cast<TTree *>(file_->Get(tree_name.c_str()));
-    if (!tree_) {
-      EXCEPTION_RAISE("FileError", "File '" + fileName_ +
-                                       "' does not have a TTree named '" +
-                                       tree_name + "' in it.");
+    TKey *key{file_->GetKey(tree_name.c_str())};
+    if (key and std::string(key->GetClassName()).find("RNTuple") !=
+                    std::string::npos) {
+      // events stored in an RNTuple instead of a TTree
+      ntupleSource_ = std::make_unique<RNTupleSource>(fileName_, tree_name);
+      entries_ = ntupleSource_->getEntries();
+    } else {
+      tree_ = static_cast<TTree *>(file_->Get(tree_name.c_str()));
+      if (!tree_) {
+        EXCEPTION_RAISE("FileError", "File '" + fileName_ +
+                                         "' does not have a TTree named '" +
+                                         tree_name + "' in it.");
+      }
+      entries_ = tree_->GetEntriesFast();
+      // the events are read one at a time on the main thread, ROOT's
+      // implicit multi-threading is only meant for the output
+      tree_->SetImplicitMT(false);
     }
-    entries_ = tree_->GetEntriesFast();
   }
 
   importRunHeaders();
@@ -88,9 +144,14 @@ EventFile::EventFile(const framework::config::Parameters &params,
 EventFile::~EventFile() {
   // Before an output file, the Event tree needs to be written.
   if (isOutputFile_) {
-    // make sure we are in output file before writing
-    file_->cd();
-    tree_->Write();
+    if (ntupleSink_) {
+      // the RNTuple is committed to the file when its writer is destroyed
+      ntupleSink_.reset();
+    } else {
+      // make sure we are in output file before writing
+      file_->cd();
+      tree_->Write();
+    }
   }
 
   // Close the file
@@ -145,7 +206,10 @@ void EventFile::addDrop(const std::string &rule) {
   } else if (isDrop) {
     // drop means allowing it on reading but not writing
     // pass these regex to event bus so Event::add knows
-    event_->addDrop(srule);  // requires event_ to be set
+    if (event_)
+      event_->addDrop(srule);
+    else
+      streamDrops_.push_back(srule);  // given to the event by setupStream
 
     // root needs . removed otherwise it gets cranky
     srule.erase(std::remove(srule.begin(), srule.end(), '.'), srule.end());
@@ -168,22 +232,7 @@ bool EventFile::nextEvent(bool storeCurrentEvent) {
       // Only clone parent tree if either
       //  1) There is no tree setup yet (first input file)
       //  2) This is not single output (new input file --> new output file)
-      if (!tree_ or !isSingleOutput_) {
-        // clones parent_->tree_ to our tree_ keeping drop/keep rules in mind
-        // clone tree (only copies over branches that are active on input tree)
-
-        file_->cd();  // go into output file
-
-        for (auto const &rulePair : preCloneRules_)
-          parent_->tree_->SetBranchStatus(rulePair.first.c_str(),
-                                          rulePair.second);
-
-        tree_ = parent_->tree_->CloneTree(0);
-
-        // reactivate any drop branches (drop) on input tree
-        for (auto const &rule : reactivateRules_)
-          parent_->tree_->SetBranchStatus(rule.c_str(), 1);
-      }
+      if (!tree_ or !isSingleOutput_) cloneParentTree();
       event_->setInputTree(parent_->tree_);
       event_->setOutputTree(tree_);
     }  // we have a parent file
@@ -191,9 +240,15 @@ bool EventFile::nextEvent(bool storeCurrentEvent) {
     // later than first entry of file
     if (isOutputFile_) {
       event_->beforeFill();
-      if (storeCurrentEvent)  // we should store before moving on
-        tree_->Fill();        // fill the clones...
-    }                         // we are an output file
+      if (storeCurrentEvent) {  // we should store before moving on
+        if (ntupleSink_) {
+          ntupleSink_->fill();
+        } else {
+          applyCompressionRules();
+          tree_->Fill();  // fill the clones...
+        }
+      }
+    }  // we are an output file
 
     // the event bus may not be defined
     //  for this file if we are input file and
@@ -230,7 +285,11 @@ bool EventFile::nextEvent(bool storeCurrentEvent) {
         return false;
     }
     ientry_++;
-    tree_->GetEntry(ientry_);
+    if (ntupleSource_)
+      ntupleSource_->setEntry(ientry_);
+    else
+      tree_->GetEntry(ientry_);
+    if (cache_) cache_->setEntry(ientry_);
   }
 
   // if we have an event_
@@ -244,8 +303,8 @@ void EventFile::setupEvent(Event *evt) {
     // we are an output file
     if (!tree_ && !parent_) {
       // we don't have a tree and we don't have a parent
-      //  ==> *Production Mode* create a new tree
-      tree_ = event_->createTree();
+      //  ==> *Production Mode* create a new tree (unless we use an RNTuple)
+      if (!ntupleSink_) tree_ = event_->createTree();
       ientry_ = 0;
       entries_ = 0;
     }
@@ -258,14 +317,59 @@ void EventFile::setupEvent(Event *evt) {
     }
 
     // give our tree to the event as the output tree
-    event_->setOutputTree(tree_);
+    if (ntupleSink_)
+      event_->setOutputNTuple(ntupleSink_.get());
+    else
+      event_->setOutputTree(tree_);
   } else {
     // we are an input file
     //  so give our tree to the event as input tree
-    event_->setInputTree(tree_);
+    if (ntupleSource_)
+      event_->setInputNTuple(ntupleSource_.get());
+    else
+      event_->setInputTree(tree_);
+    if (cache_) event_->setInputCache(cache_.get());
   }  // output or input file
 }
 
+void EventFile::setupStream(Event *evt) {
+  if (not isOutputFile_ or ntupleSink_) {
+    EXCEPTION_RAISE("NotSupported",
+                    "Only output files with an event TTree can be written "
+                    "as an output stream.");
+  }
+  event_ = evt;
+  if (parent_) {
+    cloneParentTree();
+  } else {
+    file_->cd();
+    tree_ = new TTree("LDMX_Events", "LDMX Events");
+  }
+  event_->addStreamTree(tree_, streamDrops_);
+}
+
+void EventFile::fillStream(bool storeCurrentEvent) {
+  event_->beforeFill();
+  if (storeCurrentEvent) {
+    applyCompressionRules();
+    tree_->Fill();
+  }
+}
+
+void EventFile::useCache(const std::string &directory,
+                         const std::vector<std::string> &collections) {
+  if (isOutputFile_ or not tree_) {
+    EXCEPTION_RAISE("MisCall",
+                    "Only input files with an event TTree can be cached.");
+  }
+
+  cache_ = std::make_unique<EventCache>(file_, tree_, directory, collections);
+
+  // don't read the cached branches from the tree anymore
+  for (const auto &branch : cache_->getBranches())
+    tree_->SetBranchStatus(branch.c_str(), 0);
+}
+
 int EventFile::skipToEvent(int offset) {
   // make sure the event number exists
   ientry_ = offset % entries_ - 1;
@@ -275,6 +379,13 @@ int EventFile::skipToEvent(int offset) {
 void EventFile::updateParent(EventFile *parent) {
   parent_ = parent;
 
+  if (parent_->ntupleSource_) {
+    EXCEPTION_RAISE("NotSupported",
+                    "Unable to copy events from the RNTuple in '" +
+                        parent_->fileName_ + "' into the output file '" +
+                        fileName_ + "'.");
+  }
+
   // we can assume parent_->tree_ is valid
   //  because (for input files) the tree_ is imported
   //  from the file and then checked if its valid in the
@@ -367,6 +478,12 @@ ldmx::RunHeader *EventFile::getRunHeaderPtr(int runNumber) {
   return nullptr;
 }
 
+ldmx::RunHeader *EventFile::getNextRunHeaderPtr(int runNumber) {
+  auto next{runMap_.upper_bound(runNumber)};
+  if (next != runMap_.end()) return next->second.second;
+  return nullptr;
+}
+
 ldmx::RunHeader &EventFile::getRunHeader(int runNumber) {
   ldmx::RunHeader *rh{this->getRunHeaderPtr(runNumber)};
   if (rh != nullptr) {
@@ -376,6 +493,40 @@ ldmx::RunHeader &EventFile::getRunHeader(int runNumber) {
                   "Unable to find header for run " + std::to_string(runNumber));
 }
 
+void EventFile::applyCompressionRules() {
+  if (compressionRules_.empty()) return;
+  TObjArray *branches{tree_->GetListOfBranches()};
+  for (; nBranchesCompressed_ < branches->GetEntriesFast();
+       nBranchesCompressed_++) {
+    auto branch{static_cast<TBranch *>(branches->At(nBranchesCompressed_))};
+    std::string name{branch->GetName()};
+    for (auto it{compressionRules_.rbegin()}; it != compressionRules_.rend();
+         ++it) {
+      if (std::regex_match(name, it->first)) {
+        // also sets the compression of all the sub-branches
+        branch->SetCompressionSettings(it->second);
+        break;
+      }
+    }
+  }
+}
+
+void EventFile::cloneParentTree() {
+  // clones parent_->tree_ to our tree_ keeping drop/keep rules in mind
+  // clone tree (only copies over branches that are active on input tree)
+
+  file_->cd();  // go into output file
+
+  for (auto const &rulePair : preCloneRules_)
+    parent_->tree_->SetBranchStatus(rulePair.first.c_str(), rulePair.second);
+
+  tree_ = parent_->tree_->CloneTree(0);
+
+  // reactivate any drop branches (drop) on input tree
+  for (auto const &rule : reactivateRules_)
+    parent_->tree_->SetBranchStatus(rule.c_str(), 1);
+}
+
 void EventFile::importRunHeaders() {
   // choose which file to import from
   auto theImportFile{file_};  // if this is an input file
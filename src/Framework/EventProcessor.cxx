@@ -18,6 +18,21 @@ Conditions &EventProcessor::getConditions() const {
   return process_.getConditions();
 }
 
+void EventProcessor::requireCondition(const std::string &condition_name) {
+  getConditions().require(condition_name);
+}
+
+void EventProcessor::parallelFor(std::size_t begin, std::size_t end,
+                                 const std::function<void(std::size_t)> &fn) {
+  ThreadPool *pool{process_.getThreadPool()};
+  if (pool and end > begin + 1) {
+    // the pool threads need the event of the calling pipeline stage
+    pool->parallelFor(begin, end, process_.withThreadEvent(fn));
+  } else {
+    for (std::size_t i{begin}; i < end; i++) fn(i);
+  }
+}
+
 const ldmx::EventHeader &EventProcessor::getEventHeader() const {
   return *(process_.getEventHeader());
 }
@@ -32,7 +47,7 @@ TDirectory *EventProcessor::getHistoDirectory() {
 
 void EventProcessor::setStorageHint(framework::StorageControl::Hint hint,
                                     const std::string &purposeString) {
-  process_.getStorageController().addHint(name_, hint, purposeString);
+  process_.addStorageHint(name_, hint, purposeString);
 }
 
 int EventProcessor::getLogFrequency() const {
@@ -1,9 +1,19 @@
 #include "Framework/Logger.h"
 
 // STL
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <ostream>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 // Boost
 #include <boost/core/null_deleter.hpp>  //to avoid deleting std::cout
@@ -13,6 +23,135 @@ namespace framework {
 
 namespace logging {
 
+namespace {
+
+// some helpful types
+typedef sinks::text_ostream_backend ourSinkBack_t;
+typedef sinks::synchronous_sink<ourSinkBack_t> syncSink_t;
+typedef sinks::asynchronous_sink<
+    ourSinkBack_t, sinks::bounded_fifo_queue<ASYNC_QUEUE_SIZE,
+                                             sinks::block_on_overflow>>
+    blockingSink_t;
+typedef sinks::asynchronous_sink<
+    ourSinkBack_t,
+    sinks::bounded_fifo_queue<ASYNC_QUEUE_SIZE, sinks::drop_on_overflow>>
+    droppingSink_t;
+
+/**
+ * The thread writing the records of an asynchronous sink
+ *
+ * We run the feeding loop of the sink on our own thread rather than
+ * letting boost start one so that it can be stopped and restarted
+ * around a fork.
+ */
+struct Feeder {
+  /// run the feeding loop of the sink until it is stopped
+  std::function<void()> run;
+  /// stop the feeding loop if it is running
+  std::function<void()> stop;
+  /// write out whatever is left in the queue on the calling thread
+  std::function<void()> flush;
+  /// thread running the feeding loop, not joinable while suspended
+  std::thread thread;
+  /// guards the started and done flags
+  std::mutex mutex;
+  /// signalled when the started or done flag is set
+  std::condition_variable cv;
+  /// set by the thread right before entering the feeding loop
+  bool started{false};
+  /// set by the thread once the feeding loop returned
+  bool done{false};
+
+  /// start the thread running the feeding loop
+  void start() {
+    started = false;
+    done = false;
+    thread = std::thread([this]() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        started = true;
+      }
+      cv.notify_all();
+      run();
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+      }
+      cv.notify_all();
+    });
+  }
+
+  /// stop the thread and write out what is left in the queue
+  void finish() {
+    if (not thread.joinable()) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]() { return started; });
+    // stopping does nothing in the short time between the flag being set
+    // and the loop registering with the sink, so it is retried until the
+    // loop returned, which is normally after the first stop
+    while (not done) {
+      lock.unlock();
+      stop();
+      lock.lock();
+      cv.wait_for(lock, std::chrono::milliseconds(1), [this]() { return done; });
+    }
+    lock.unlock();
+    thread.join();
+    flush();
+  }
+};
+
+/// the feeders of the open asynchronous sinks
+std::vector<std::unique_ptr<Feeder>> feeders;
+
+/**
+ * Format a record
+ *
+ * TODO change format to something helpful
+ * Currently:
+ *  [ Channel ] int severity : message
+ */
+void format(const log::record_view &view, log::formatting_ostream &os) {
+  os
+      //                            <<
+      //                            log::extract<boost::date_time::int_adapter>(
+      //                            "TimeStamp" , view )
+      << " [ " << log::extract<std::string>("Channel", view) << " ] "
+      << /*humanReadableLevel.at*/ (log::extract<level>("Severity", view))
+      << " : " << view[log::expressions::smessage];
+}
+
+/**
+ * Wrap a backend into a sink and add it to the logging core
+ *
+ * @param Sink type of sink frontend to use
+ * @param[in] back backend writing the records
+ * @param[in] lvl minimum level of records to write
+ */
+template <typename Sink>
+void addSink(boost::shared_ptr<ourSinkBack_t> back, level lvl) {
+  boost::shared_ptr<Sink> sink;
+  if constexpr (std::is_same_v<Sink, syncSink_t>) {
+    sink = boost::make_shared<Sink>(back);
+  } else {
+    sink = boost::make_shared<Sink>(back, false);
+    auto feeder{std::make_unique<Feeder>()};
+    feeder->run = [sink]() { sink->run(); };
+    feeder->stop = [sink]() { sink->stop(); };
+    feeder->flush = [sink]() { sink->flush(); };
+    feeder->start();
+    feeders.push_back(std::move(feeder));
+  }
+
+  // this is where the logging level is set
+  sink->set_filter(log::expressions::attr<level>("Severity") >= lvl);
+  sink->set_formatter(&format);
+
+  log::core::get()->add_sink(sink);
+}
+
+}  // namespace
+
 level convertLevel(int &iLvl) {
   if (iLvl < 0)
     iLvl = 0;
@@ -27,11 +166,7 @@ logger makeLogger(const std::string &name) {
 }
 
 void open(const level termLevel, const level fileLevel,
-          const std::string &fileName) {
-  // some helpful types
-  typedef sinks::text_ostream_backend ourSinkBack_t;
-  typedef sinks::synchronous_sink<ourSinkBack_t> ourSinkFront_t;
-
+          const std::string &fileName, bool async, bool dropOnOverflow) {
   // allow our logs to access common attributes, the ones availabe are
   //  "LineID"    : counter increments for each record being made (terminal or
   //  file) "TimeStamp" : time the log message was created "ProcessID" : machine
@@ -39,8 +174,24 @@ void open(const level termLevel, const level fileLevel,
   //  the message is in
   log::add_common_attributes();
 
-  // get the core logging service
-  boost::shared_ptr<log::core> core = log::core::get();
+  // skip making records that no sink will print
+  minLevel = fileName.empty() ? termLevel : std::min(termLevel, fileLevel);
+
+  // a program exiting without closing the logging would otherwise
+  // destroy the feeding threads while they are running, registering
+  // this after the logging core exists makes it run before the core
+  // is destroyed
+  static bool closeAtExit{std::atexit([]() { close(); }) == 0};
+  (void)closeAtExit;
+
+  auto add = [&](boost::shared_ptr<ourSinkBack_t> back, level lvl) {
+    if (not async)
+      addSink<syncSink_t>(back, lvl);
+    else if (dropOnOverflow)
+      addSink<droppingSink_t>(back, lvl);
+    else
+      addSink<blockingSink_t>(back, lvl);
+  };
 
   // file sink is optional
   //  don't even make it if no fileName is provided
@@ -48,29 +199,7 @@ void open(const level termLevel, const level fileLevel,
     boost::shared_ptr<ourSinkBack_t> fileBack =
         boost::make_shared<ourSinkBack_t>();
     fileBack->add_stream(boost::make_shared<std::ofstream>(fileName));
-
-    boost::shared_ptr<ourSinkFront_t> fileSink =
-        boost::make_shared<ourSinkFront_t>(fileBack);
-
-    // this is where the logging level is set
-    fileSink->set_filter(log::expressions::attr<level>("Severity") >=
-                         fileLevel);
-
-    // TODO change format to something helpful
-    // Currently:
-    //  [ Channel ] int severity : message
-    fileSink->set_formatter([](const log::record_view &view,
-                               log::formatting_ostream &os) {
-      os
-          //                            <<
-          //                            log::extract<boost::date_time::int_adapter>(
-          //                            "TimeStamp" , view )
-          << " [ " << log::extract<std::string>("Channel", view) << " ] "
-          << /*humanReadableLevel.at*/ (log::extract<level>("Severity", view))
-          << " : " << view[log::expressions::smessage];
-    });
-
-    core->add_sink(fileSink);
+    add(fileBack, fileLevel);
   }  // file set to pass something
 
   // terminal sink is always created
@@ -82,36 +211,30 @@ void open(const level termLevel, const level fileLevel,
       ));
   // flushes message to screen **after each message**
   termBack->auto_flush(true);
-
-  boost::shared_ptr<ourSinkFront_t> termSink =
-      boost::make_shared<ourSinkFront_t>(termBack);
-
-  // translate integer level to enum
-  termSink->set_filter(log::expressions::attr<level>("Severity") >= termLevel);
-
-  // TODO change format to something helpful
-  // Currently:
-  //  [ Channel ](int severity) : message
-  termSink->set_formatter([](const log::record_view &view,
-                             log::formatting_ostream &os) {
-    os
-        //                        <<
-        //                        log::extract<boost::date_time::int_adapter>(
-        //                        "TimeStamp" , view )
-        << " [ " << log::extract<std::string>("Channel", view) << " ] "
-        << /*humanReadableLevel.at*/ (log::extract<level>("Severity", view))
-        << " : " << view[log::expressions::smessage];
-  });
-
-  core->add_sink(termSink);
+  add(termBack, termLevel);
 
   return;
 
 }  // open
 
+void suspend() {
+  for (auto &feeder : feeders) feeder->finish();
+}
+
+void resume() {
+  for (auto &feeder : feeders) {
+    if (not feeder->thread.joinable()) feeder->start();
+  }
+}
+
 void close() {
+  suspend();
+  feeders.clear();
+
   // prevents crashes on some systems when logging to a file
   log::core::get()->remove_all_sinks();
+  // without sinks boost prints everything
+  minLevel = debug;
 
   return;
 }
@@ -0,0 +1,93 @@
+#include "Framework/OverlaySource.h"
+
+#include <limits>
+
+#include "TROOT.h"
+
+namespace framework {
+
+OverlaySource::OverlaySource(const config::Parameters &params,
+                             const std::string &fileName, std::size_t poolSize,
+                             int eventsPerPool)
+    : pools_{std::vector<Bus>(poolSize), std::vector<Bus>(poolSize)},
+      eventsPerPool_{eventsPerPool},
+      file_(params, fileName, true) {
+  if (poolSize == 0 or eventsPerPool < 1) {
+    EXCEPTION_RAISE("OverlaySource",
+                    "The overlay pool needs at least one event and needs to "
+                    "be used for at least one primary event.");
+  }
+  if (not file_.getTree()) {
+    EXCEPTION_RAISE("OverlaySource", "Overlay events can only be read from a "
+                                     "TTree, not from '" +
+                                         fileName + "'.");
+  }
+  // the pools are read on another thread
+  ROOT::EnableThreadSafety();
+}
+
+OverlaySource::~OverlaySource() {
+  if (refill_.valid()) refill_.wait();
+}
+
+void OverlaySource::sample(std::size_t n) {
+  if (not started_) {
+    start();
+  } else if (nSampledFromPool_ == eventsPerPool_) {
+    // move on to the pool read in the meantime and start
+    // reading the next events into the one we are done with
+    refill_.get();
+    active_ = 1 - active_;
+    int next{1 - active_};
+    refill_ = std::async(std::launch::async,
+                         [this, next]() { fill(pools_[next]); });
+    nSampledFromPool_ = 0;
+  }
+  nSampledFromPool_++;
+
+  std::uniform_int_distribution<std::size_t> pick(
+      0, pools_[active_].size() - 1);
+  sampled_.resize(n);
+  for (auto &i : sampled_) i = pick(engine_);
+}
+
+void OverlaySource::start() {
+  TTree *tree{file_.getTree()};
+  if (tree->GetEntries() == 0) {
+    EXCEPTION_RAISE("OverlaySource", "The overlay file '" +
+                                         file_.getFileName() +
+                                         "' has no events.");
+  }
+
+  // only read what we overlay
+  tree->SetBranchStatus("*", 0);
+  for (const auto &branch : branches_) {
+    if (not tree->GetBranch(branch.c_str())) {
+      EXCEPTION_RAISE("OverlaySource", "The overlay file '" +
+                                           file_.getFileName() +
+                                           "' has no branch '" + branch +
+                                           "'.");
+    }
+    tree->SetBranchStatus((branch + "*").c_str(), 1);
+  }
+
+  // start at a random place so that jobs don't overlay the same events
+  file_.skipToEvent(engine_() % std::numeric_limits<int>::max());
+
+  fill(pools_[active_]);
+  int next{1 - active_};
+  refill_ =
+      std::async(std::launch::async, [this, next]() { fill(pools_[next]); });
+  started_ = true;
+}
+
+void OverlaySource::fill(std::vector<Bus> &pool) {
+  TTree *tree{file_.getTree()};
+  for (Bus &event : pool) {
+    // read straight into the buffers of this event
+    for (const auto &branch : branches_) event.attach(tree, branch, false);
+    file_.nextEvent();
+  }
+}
+
+}  // namespace framework
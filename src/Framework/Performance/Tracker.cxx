@@ -1,5 +1,7 @@
 #include "Framework/Performance/Tracker.h"
 
+#include <TParameter.h>
+
 namespace framework::performance {
 
 const std::string Tracker::ALL = "__ALL__";
@@ -55,6 +57,8 @@ Tracker::Tracker(TDirectory* storage_directory,
    * https://root.cern.ch/root/htmldoc/guides/users-guide/Trees.html#adding-a-tbranch-to-hold-an-object
    */
   event_data_->Branch("completed", &event_completed_);
+  event_data_->Branch("skipped", &event_skipped_);
+  skipped_.resize(names_.size(), 0);
   for (std::size_t i{0}; i < names_.size(); i++) {
     event_data_->Branch((names_[i] + ".").c_str(),
                         &(processor_timers_[to_index(Callback::process)][i]));
@@ -81,6 +85,17 @@ Tracker::~Tracker() {
                                                           names_[i_proc]);
     }
   }
+
+  /**
+   * Write the number of events each processor was skipped for,
+   * the entry for all processors is the number of events where
+   * any processor was skipped
+   */
+  TDirectory* skipped_d = storage_directory_->mkdir("skipped");
+  for (std::size_t i_proc{0}; i_proc < names_.size(); i_proc++) {
+    TParameter<Long64_t> count(names_[i_proc].c_str(), skipped_[i_proc]);
+    skipped_d->WriteObject(&count, names_[i_proc].c_str());
+  }
 }
 
 void Tracker::absolute_start() { absolute_.start(); }
@@ -95,9 +110,16 @@ void Tracker::stop(Callback callback, std::size_t i_proc) {
   processor_timers_[to_index(callback)][i_proc].stop();
 }
 
+void Tracker::skip(std::size_t i_proc) {
+  if (event_skipped_ == 0) skipped_[0]++;
+  skipped_[i_proc]++;
+  event_skipped_++;
+}
+
 void Tracker::end_event(bool completed) {
   event_completed_ = completed;
   event_data_->Fill();
+  event_skipped_ = 0;
   /**
    * Make sure to reset the timer _after_ the event data has been filled
    * so that if a future event is not completed (and some timers are not
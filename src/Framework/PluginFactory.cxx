@@ -2,6 +2,9 @@
 
 #include <dlfcn.h>
 
+#include <filesystem>
+#include <fstream>
+
 #include "Framework/EventProcessor.h"
 
 framework::PluginFactory framework::PluginFactory::theFactory_
@@ -9,6 +12,28 @@ framework::PluginFactory framework::PluginFactory::theFactory_
 
 namespace framework {
 
+namespace {
+
+/**
+ * Normalize the path to a library so it can be compared
+ *
+ * Bare library names are left alone since dlopen looks for them in
+ * the library search path, paths have their symbolic links and relative
+ * components resolved as far as they exist.
+ *
+ * @param[in] libname name of or path to library
+ * @returns normalized path to library
+ */
+std::string normalizeLibrary(const std::string& libname) {
+  if (libname.find('/') == std::string::npos) return libname;
+  std::error_code ec;
+  auto path{std::filesystem::weakly_canonical(libname, ec)};
+  if (ec) return std::filesystem::path(libname).lexically_normal().string();
+  return path.string();
+}
+
+}  // namespace
+
 PluginFactory::PluginFactory() {}
 
 void PluginFactory::registerEventProcessor(const std::string& classname,
@@ -25,6 +50,7 @@ void PluginFactory::registerEventProcessor(const std::string& classname,
   mi.classtype = classtype;
   mi.ep_maker = maker;
   mi.cop_maker = 0;
+  mi.library = libraryLoading_;
   moduleInfo_[classname] = mi;
 }
 
@@ -42,6 +68,7 @@ void PluginFactory::registerConditionsObjectProvider(
   mi.classtype = classtype;
   mi.cop_maker = maker;
   mi.ep_maker = 0;
+  mi.library = libraryLoading_;
   moduleInfo_[classname] = mi;
 }
 
@@ -66,7 +93,7 @@ int PluginFactory::getEventProcessorClasstype(const std::string& ct) const {
 EventProcessor* PluginFactory::createEventProcessor(
     const std::string& classname, const std::string& moduleInstanceName,
     Process& process) {
-  auto ptr = moduleInfo_.find(classname);
+  auto ptr = findClass(classname);
   if (ptr == moduleInfo_.end() || ptr->second.ep_maker == 0) {
     return 0;
   }
@@ -77,7 +104,7 @@ ConditionsObjectProvider* PluginFactory::createConditionsObjectProvider(
     const std::string& classname, const std::string& objName,
     const std::string& tagname, const framework::config::Parameters& params,
     Process& process) {
-  auto ptr = moduleInfo_.find(classname);
+  auto ptr = findClass(classname);
   if (ptr == moduleInfo_.end() || ptr->second.cop_maker == 0) {
     return 0;
   }
@@ -89,7 +116,9 @@ void PluginFactory::loadLibrary(const std::string& libname) {
     return;  // already loaded
   }
 
+  libraryLoading_ = libname;
   void* handle = dlopen(libname.c_str(), RTLD_NOW);
+  libraryLoading_.clear();
   if (handle == nullptr) {
     EXCEPTION_RAISE("LibraryLoadFailure",
                     "Error loading library '" + libname + "':" + dlerror());
@@ -98,4 +127,41 @@ void PluginFactory::loadLibrary(const std::string& libname) {
   librariesLoaded_.insert(libname);
 }
 
+bool PluginFactory::readIndex(const std::string& indexFile) {
+  std::ifstream index(indexFile);
+  if (not index) return false;
+  std::string classname, libname;
+  while (index >> classname >> libname) {
+    index_[classname] = libname;
+    indexedLibraries_.insert(normalizeLibrary(libname));
+  }
+  return true;
+}
+
+void PluginFactory::writeIndex(const std::string& indexFile) const {
+  std::ofstream index(indexFile);
+  for (const auto& [classname, info] : moduleInfo_) {
+    if (not info.library.empty())
+      index << classname << " " << normalizeLibrary(info.library) << "\n";
+  }
+  if (not index) {
+    EXCEPTION_RAISE("PluginIndex",
+                    "Unable to write plugin index '" + indexFile + "'.");
+  }
+}
+
+bool PluginFactory::isIndexed(const std::string& libname) const {
+  return indexedLibraries_.count(normalizeLibrary(libname)) > 0;
+}
+
+std::map<std::string, PluginFactory::PluginInfo>::const_iterator
+PluginFactory::findClass(const std::string& classname) {
+  auto ptr = moduleInfo_.find(classname);
+  if (ptr != moduleInfo_.end()) return ptr;
+  auto lib = index_.find(classname);
+  if (lib == index_.end()) return moduleInfo_.end();
+  loadLibrary(lib->second);
+  return moduleInfo_.find(classname);
+}
+
 }  // namespace framework
@@ -5,7 +5,23 @@
 
 #include "Framework/Process.h"
 
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <utility>
 
 #include "Framework/Event.h"
 #include "Framework/EventFile.h"
@@ -15,11 +31,222 @@
 #include "Framework/NtupleManager.h"
 #include "Framework/PluginFactory.h"
 #include "Framework/RunHeader.h"
+#include "Framework/SPSCQueue.h"
 #include "TFile.h"
+#include "TFileMerger.h"
+#include "TH1.h"
 #include "TROOT.h"
+#include "TSystem.h"
+#include "TTree.h"
 
 namespace framework {
 
+namespace {
+
+/**
+ * Check if any of the names in the first list are in the second list
+ */
+bool overlap(const std::vector<std::string> &a,
+             const std::vector<std::string> &b) {
+  for (const auto &name : a) {
+    if (std::find(b.begin(), b.end(), name) != b.end()) return true;
+  }
+  return false;
+}
+
+/**
+ * Check if a processor needs to run after an earlier processor
+ *
+ * @see Process::schedule for the rules
+ */
+bool dependsOn(const EventProcessor &later, const EventProcessor &earlier) {
+  auto declared = [](const EventProcessor &p) {
+    return not p.getConsumes().empty() or not p.getProduces().empty();
+  };
+  if (not declared(later) or not declared(earlier)) return true;
+  return overlap(later.getConsumes(), earlier.getProduces()) or
+         overlap(later.getProduces(), earlier.getConsumes()) or
+         overlap(later.getProduces(), earlier.getProduces());
+}
+
+/**
+ * An event in the pipeline together with its own storage decision
+ */
+struct PipelineSlot {
+  PipelineSlot(const std::string &pass) : event(pass) {}
+  /// the event being processed
+  Event event;
+  /// hints given by the processors for this event
+  StorageControl storage;
+  /// has no processor aborted this event?
+  bool completed{true};
+};
+
+/**
+ * A queue of events between two pipeline threads
+ *
+ * A thread pushing into a full queue or popping from an empty one
+ * sleeps until the thread on the other side moved an event or the
+ * pipeline failed, so a stage waiting on a slow neighbour doesn't
+ * keep a core busy.
+ */
+class PipelineQueue {
+ public:
+  /**
+   * Create an empty queue
+   *
+   * @param[in] capacity maximum number of events in the queue
+   * @param[in] failed flag telling the waiting threads to give up
+   */
+  PipelineQueue(std::size_t capacity, const std::atomic<bool> &failed)
+      : queue_{capacity}, failed_{failed} {}
+
+  /**
+   * Put an event at the end of the queue, waiting while it is full
+   *
+   * @returns false if the pipeline failed before the event was pushed
+   */
+  bool push(PipelineSlot *slot) {
+    return wait([this, slot]() { return queue_.tryPush(slot); });
+  }
+
+  /**
+   * Take the event at the front of the queue, waiting while it is empty
+   *
+   * @returns false if the pipeline failed before an event was popped
+   */
+  bool pop(PipelineSlot *&slot) {
+    return wait([this, &slot]() { return queue_.tryPop(slot); });
+  }
+
+  /**
+   * Wake up the threads waiting on this queue, e.g. after a failure
+   */
+  void interrupt() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cv_.notify_all();
+  }
+
+ private:
+  /**
+   * Wait until the input attempt to move an event succeeds
+   * or the pipeline failed, waking up the other side if it did
+   */
+  template <typename Attempt>
+  bool wait(Attempt attempt) {
+    bool moved{false};
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [&]() { return (moved = attempt()) or failed_; });
+    }
+    if (moved) cv_.notify_all();
+    return moved;
+  }
+
+ private:
+  /// the events in the queue
+  SPSCQueue<PipelineSlot *> queue_;
+  /// guards the sleeping on the condition variable
+  std::mutex mutex_;
+  /// signalled when an event was moved or the pipeline failed
+  std::condition_variable cv_;
+  /// set if any of the threads failed
+  const std::atomic<bool> &failed_;
+};
+
+/**
+ * Name of the temporary file a worker process writes instead of the input one
+ *
+ * The worker index is put in front of the extension so that
+ * 'out.root' becomes 'out_worker2.root' for the third worker.
+ */
+std::string workerFileName(const std::string &name, int worker) {
+  std::string tag{"_worker" + std::to_string(worker)};
+  auto dot{name.find_last_of('.')};
+  auto slash{name.find_last_of('/')};
+  if (dot == std::string::npos or
+      (slash != std::string::npos and dot < slash))
+    return name + tag;
+  return name.substr(0, dot) + tag + name.substr(dot);
+}
+
+/**
+ * Get the range of the input files one worker process takes
+ *
+ * Each worker takes a contiguous block of the files so that
+ * the merged output keeps the order of the events.
+ *
+ * @returns indices of the first file and one past the last file
+ */
+std::pair<std::size_t, std::size_t> workerBlock(std::size_t n_files,
+                                                int worker, int n_workers) {
+  return {n_files * worker / n_workers, n_files * (worker + 1) / n_workers};
+}
+
+/**
+ * Move the objects in memory of one directory into another
+ *
+ * Subdirectories are recreated in the destination and their
+ * objects are moved as well.
+ */
+void moveContents(TDirectory *from, TDirectory *to) {
+  // copy the list, moving the objects changes it
+  std::vector<TObject *> objects;
+  for (TObject *obj : *from->GetList()) objects.push_back(obj);
+  for (TObject *obj : objects) {
+    if (auto dir = dynamic_cast<TDirectory *>(obj)) {
+      TDirectory *copy{to->GetDirectory(dir->GetName())};
+      if (not copy) copy = to->mkdir(dir->GetName(), dir->GetTitle());
+      moveContents(dir, copy);
+    } else if (auto hist = dynamic_cast<TH1 *>(obj)) {
+      hist->SetDirectory(to);
+    } else if (auto tree = dynamic_cast<TTree *>(obj)) {
+      tree->SetDirectory(to);
+    } else {
+      from->GetList()->Remove(obj);
+      to->GetList()->Add(obj);
+    }
+  }
+}
+
+/**
+ * ROOT's implicit multi-threading, turned on for as long as this lives
+ *
+ * This makes sure it is turned back off when an exception leaves
+ * Process::run so that it doesn't stay on for anything run after.
+ */
+class ImplicitMT {
+ public:
+  ImplicitMT(unsigned int nThreads) { ROOT::EnableImplicitMT(nThreads); }
+  ~ImplicitMT() { ROOT::DisableImplicitMT(); }
+  ImplicitMT(const ImplicitMT &) = delete;
+  ImplicitMT &operator=(const ImplicitMT &) = delete;
+};
+
+/**
+ * Let a producer produce the event
+ */
+void callProduce(EventProcessor *module, Event &event) {
+  static_cast<Producer *>(module)->produce(event);
+}
+
+/**
+ * Let an analyzer analyze the event
+ */
+void callAnalyze(EventProcessor *module, Event &event) {
+  static_cast<Analyzer *>(module)->analyze(event);
+}
+
+/**
+ * Skip a processor that is neither a producer nor an analyzer
+ */
+void callNothing(EventProcessor *, Event &) {}
+
+}  // namespace
+
+thread_local const ldmx::EventHeader *Process::threadEventHeader_{nullptr};
+thread_local StorageControl *Process::threadStorageController_{nullptr};
+
 Process::Process(const framework::config::Parameters &configuration)
     : conditions_{*this} {
   config_ = configuration;
@@ -27,12 +254,18 @@ Process::Process(const framework::config::Parameters &configuration)
   passname_ = configuration.getParameter<std::string>("passName", "");
   histoFilename_ = configuration.getParameter<std::string>("histogramFile", "");
   logFileName_ = configuration.getParameter<std::string>("logFileName", "");
+  logAsync_ = configuration.getParameter<bool>("logAsync", false);
+  logDropOnOverflow_ =
+      configuration.getParameter<bool>("logDropOnOverflow", false);
 
   maxTries_ = configuration.getParameter<int>("maxTriesPerEvent", 1);
   eventLimit_ = configuration.getParameter<int>("maxEvents", -1);
   logFrequency_ = configuration.getParameter<int>("logFrequency", -1);
   compressionSetting_ =
       configuration.getParameter<int>("compressionSetting", 9);
+  numIOThreads_ = configuration.getParameter<int>("numIOThreads", 0);
+  numThreads_ = configuration.getParameter<int>("numThreads", 1);
+  numWorkers_ = configuration.getParameter<int>("numWorkers", 1);
   termLevelInt_ = configuration.getParameter<int>("termLogLevel", 2);
   fileLevelInt_ = configuration.getParameter<int>("fileLogLevel", 0);
 
@@ -42,24 +275,53 @@ Process::Process(const framework::config::Parameters &configuration)
       configuration.getParameter<std::vector<std::string>>("outputFiles", {});
   dropKeepRules_ =
       configuration.getParameter<std::vector<std::string>>("keep", {});
+  eventCacheDirectory_ =
+      configuration.getParameter<std::string>("eventCacheDirectory", "");
+  eventCacheCollections_ = configuration.getParameter<std::vector<std::string>>(
+      "eventCacheCollections", {});
 
   eventHeader_ = 0;
 
   auto run{configuration.getParameter<int>("run", -1)};
   if (run > 0) runForGeneration_ = run;
 
+  // libraries in the plugin index are loaded once one of their classes
+  // is requested, the rest could hold dictionaries and are loaded now
+  auto &factory{PluginFactory::getInstance()};
+  bool indexed{factory.readIndex(
+      configuration.getParameter<std::string>("pluginIndex", ""))};
   auto libs{
       configuration.getParameter<std::vector<std::string>>("libraries", {})};
-  std::for_each(libs.begin(), libs.end(), [](auto &lib) {
-    PluginFactory::getInstance().loadLibrary(lib);
+  std::for_each(libs.begin(), libs.end(), [&](auto &lib) {
+    if (indexed and factory.isIndexed(lib))
+      deferredLibraries_.push_back(lib);
+    else
+      factory.loadLibrary(lib);
   });
 
-  storageController_.setDefaultKeep(
-      configuration.getParameter<bool>("skimDefaultIsKeep", true));
-  auto skimRules{
-      configuration.getParameter<std::vector<std::string>>("skimRules", {})};
-  for (size_t i = 0; i < skimRules.size(); i += 2) {
-    storageController_.addRule(skimRules[i], skimRules[i + 1]);
+  earlyReject_ = configuration.getParameter<bool>("earlyReject", false);
+  skimDefaultIsKeep_ =
+      configuration.getParameter<bool>("skimDefaultIsKeep", true);
+  skimRules_ =
+      configuration.getParameter<std::vector<std::string>>("skimRules", {});
+  configureStorage(storageController_);
+
+  auto outputStreams{
+      configuration.getParameter<std::vector<framework::config::Parameters>>(
+          "outputStreams", {})};
+  for (const auto &params : outputStreams) {
+    auto stream{std::make_unique<OutputStream>()};
+    stream->name = params.getParameter<std::string>("name");
+    stream->fileName = params.getParameter<std::string>("outputFile");
+    stream->dropKeepRules =
+        params.getParameter<std::vector<std::string>>("keep", {});
+    stream->storage.setDefaultKeep(
+        params.getParameter<bool>("skimDefaultIsKeep", true));
+    auto rules{params.getParameter<std::vector<std::string>>("skimRules", {})};
+    for (std::size_t i = 0; i + 1 < rules.size(); i += 2) {
+      stream->storage.addRule(rules[i], rules[i + 1]);
+    }
+    outputStreams_.push_back(std::move(stream));
   }
 
   auto sequence{
@@ -92,9 +354,56 @@ Process::Process(const framework::config::Parameters &configuration)
       ep->createHistograms(histograms);
     }
     ep->configure(proc);
+    for (const auto &name :
+         proc.getParameter<std::vector<std::string>>("consumes", {}))
+      ep->consumes(name);
+    for (const auto &name :
+         proc.getParameter<std::vector<std::string>>("produces", {}))
+      ep->produces(name);
     sequence_.push_back(ep);
+    if (auto producer = dynamic_cast<Producer *>(ep)) {
+      plan_.push_back({ep, producer, callProduce});
+    } else if (dynamic_cast<Analyzer *>(ep)) {
+      plan_.push_back({ep, nullptr, callAnalyze});
+    } else {
+      plan_.push_back({ep, nullptr, callNothing});
+    }
+    outputOnly_.push_back(proc.getParameter<bool>("outputOnly", false));
+  }
+
+  pipelineStages_ =
+      configuration.getParameter<std::vector<int>>("pipelineStages", {});
+  pipelineDepth_ = configuration.getParameter<int>("pipelineDepth", 8);
+  if (not pipelineStages_.empty()) {
+    int n_procs{0};
+    for (int n : pipelineStages_) {
+      if (n < 1) {
+        EXCEPTION_RAISE("InvalidConfig",
+                        "Each pipeline stage needs at least one processor.");
+      }
+      n_procs += n;
+    }
+    if (n_procs != int(sequence_.size())) {
+      EXCEPTION_RAISE("InvalidConfig",
+                      "The pipeline stages have " + std::to_string(n_procs) +
+                          " processors but the sequence has " +
+                          std::to_string(sequence_.size()) + ".");
+    }
+    if (pipelineDepth_ < int(pipelineStages_.size())) {
+      EXCEPTION_RAISE("InvalidConfig",
+                      "The pipeline depth needs to be at least the number "
+                      "of pipeline stages.");
+    }
   }
 
+  conditions_.setCacheDepth(
+      configuration.getParameter<int>("conditionsCacheDepth", 2));
+  auto conditionsCacheDirectory{configuration.getParameter<std::string>(
+      "conditionsCacheDirectory", "")};
+  if (not conditionsCacheDirectory.empty())
+    conditions_.setDiskCache(conditionsCacheDirectory);
+  conditions_.setPrefetchNextRun(
+      configuration.getParameter<bool>("conditionsPrefetchNextRun", false));
   auto conditionsObjectProviders{
       configuration.getParameter<std::vector<framework::config::Parameters>>(
           "conditionsObjectProviders", {})};
@@ -109,6 +418,11 @@ Process::Process(const framework::config::Parameters &configuration)
 
   bool logPerformance =
       configuration.getParameter<bool>("logPerformance", false);
+  if (logPerformance and numWorkers_ > 1) {
+    EXCEPTION_RAISE("InvalidConfig",
+                    "Performance can't be logged when using several "
+                    "worker processes.");
+  }
   if (logPerformance) {
     std::vector<std::string> names{sequence_.size()};
     for (std::size_t i{0}; i < sequence_.size(); i++) {
@@ -138,12 +452,14 @@ void Process::run() {
   // set up the logging for this run
   logging::open(logging::convertLevel(termLevelInt_),
                 logging::convertLevel(fileLevelInt_),
-                logFileName_  // if this is empty string, no file is logged to
-  );
+                logFileName_,  // if this is empty string, no file is logged to
+                logAsync_, logDropOnOverflow_);
 
-  // Counter to keep track of the number of events that have been
-  // procesed
-  auto n_events_processed{0};
+  for (const auto &lib : deferredLibraries_) {
+    ldmx_log(debug) << "Loading '" << lib
+                    << "' from the plugin index once one of its classes "
+                       "is used.";
+  }
 
   // make sure the ntuple manager is in a blank state
   NtupleManager::getInstance().reset();
@@ -172,6 +488,53 @@ void Process::run() {
   if (performance_)
     performance_->stop(performance::Callback::onProcessStart, 0);
 
+  // The workers share everything set up so far, so no threads can
+  // be started before this point
+  if (numWorkers_ > 1 and startWorkers()) {
+    // the workers processed the events, we only collect their outputs
+    mergeWorkers();
+    logging::close();
+    return;
+  }
+  if (worker_ >= 0) finishWorker(theEvent);
+
+  processEvents(theEvent);
+
+  // we're done so let's close up the logging
+  logging::close();
+  if (performance_) performance_->absolute_stop();
+}
+
+void Process::processEvents(Event &theEvent) {
+  // Counter to keep track of the number of events that have been
+  // procesed
+  auto n_events_processed{0};
+
+  // Let ROOT compress the output baskets in parallel. The input trees
+  // are opted out in EventFile so this is only used for the output.
+  bool useIOThreads{numIOThreads_ > 0};
+  if (useIOThreads and outputFiles_.empty() and outputStreams_.empty()) {
+    ldmx_log(warn) << "I/O threads requested but there are no output event "
+                      "files, not using them.";
+    useIOThreads = false;
+  }
+  std::unique_ptr<ImplicitMT> implicitMT;
+  if (useIOThreads) {
+    implicitMT = std::make_unique<ImplicitMT>(numIOThreads_);
+    ldmx_log(info) << "Compressing output with " << ROOT::GetThreadPoolSize()
+                   << " threads";
+  }
+
+  // Run the processors that don't depend on each other concurrently
+  if (numThreads_ > 1) {
+    schedule();
+    // the processors may use ROOT from several threads now
+    ROOT::EnableThreadSafety();
+    threadPool_ = std::make_unique<ThreadPool>(numThreads_ - 1);
+  }
+
+  theEvent.setConcurrent(bool(threadPool_));
+
   // If we have no input files, but do have an event number, run for
   // that number of events and generate an output file.
   if (inputFiles_.empty() && eventLimit_ > 0) {
@@ -197,12 +560,36 @@ void Process::run() {
     runHeader.setRunStart(std::time(nullptr));  // set run starting
     runHeader_ = &runHeader;            // give handle to run header to process
     outFile.writeRunHeader(runHeader);  // add run header to file
+    openStreams(theEvent, nullptr, &runHeader);
 
     newRun(runHeader);
 
+    bool usePipeline{not pipelineStages_.empty()};
+    if (usePipeline and maxTries_ > 1) {
+      ldmx_log(warn) << "Events can't be retried in a pipeline, "
+                        "not using the pipeline stages.";
+      usePipeline = false;
+    }
+    if (usePipeline and not outputStreams_.empty()) {
+      ldmx_log(warn) << "Output streams can't be filled from a pipeline, "
+                        "not using the pipeline stages.";
+      usePipeline = false;
+    }
+    // the stages would set the ntuple variables of later events
+    // while the variables of earlier events are being filled
+    if (usePipeline and NtupleManager::getInstance().hasTrees()) {
+      ldmx_log(warn) << "Ntuples can't be filled from a pipeline, "
+                        "not using the pipeline stages.";
+      usePipeline = false;
+    }
+
     int totalTries = 0;  // total number of tries for entire run
     int numTries = 0;    // number of tries for the current event number
-    while (n_events_processed < eventLimit_) {
+    if (usePipeline) {
+      n_events_processed = runPipeline(outFile, theEvent);
+      totalTries = n_events_processed;
+    }
+    while (not usePipeline and n_events_processed < eventLimit_) {
       totalTries++;
       numTries++;
 
@@ -215,7 +602,9 @@ void Process::run() {
       storageController_.resetEventState();
 
       bool completed = process(n_events_processed, theEvent);
+      conditions_.onEndOfEvent();
 
+      fillStreams(completed);
       outFile.nextEvent(storageController_.keepEvent(completed));
 
       // reset try counter only on successfully completed events
@@ -237,6 +626,7 @@ void Process::run() {
     runHeader.setNumTries(totalTries);
     ldmx_log(info) << runHeader;
     outFile.writeRunTree();
+    closeStreams();
 
   } else {
     // there are input files
@@ -253,6 +643,15 @@ void Process::run() {
                       "output files (other than zero/one ouput file).");
     }
 
+    bool useEventCache{not eventCacheDirectory_.empty() and
+                       not eventCacheCollections_.empty()};
+    if (useEventCache and
+        (not outputFiles_.empty() or not outputStreams_.empty())) {
+      ldmx_log(warn) << "The event cache is only used when there are no "
+                        "output event files or streams, not using it.";
+      useEventCache = false;
+    }
+
     // next, loop through the files
     int ifile = 0;
     int wasRun = -1;
@@ -294,10 +693,14 @@ void Process::run() {
 
       } else {
         // empty output file list, use inputFile as master file
+        if (useEventCache)
+          inFile.useCache(eventCacheDirectory_, eventCacheCollections_);
         inFile.setupEvent(&theEvent);
         masterFile = &inFile;
       }
 
+      openStreams(theEvent, &inFile, nullptr);
+
       bool event_completed = true;
       while (masterFile->nextEvent(
                  storageController_.keepEvent(event_completed)) &&
@@ -308,6 +711,8 @@ void Process::run() {
         // notify for new run if necessary
         if (theEvent.getEventHeader().getRun() != wasRun) {
           wasRun = theEvent.getEventHeader().getRun();
+          // even without a run header, cached conditions may be out of date
+          conditions_.invalidate();
           ldmx::RunHeader *rh{masterFile->getRunHeaderPtr(wasRun)};
           if (rh != nullptr) {
             runHeader_ = rh;
@@ -315,6 +720,9 @@ void Process::run() {
                            << masterFile->getFileName() << "' ...\n"
                            << *runHeader_;
             newRun(*runHeader_);
+            // start loading the conditions for the run that comes next
+            ldmx::RunHeader *next{masterFile->getNextRunHeaderPtr(wasRun)};
+            if (next != nullptr) conditions_.prefetch(next->getRunNumber());
           } else {
             ldmx_log(warn) << "Run header for run " << wasRun
                            << " was not found!";
@@ -322,6 +730,8 @@ void Process::run() {
         }
 
         event_completed = process(n_events_processed, theEvent);
+        conditions_.onEndOfEvent();
+        fillStreams(event_completed);
 
         if (event_completed) NtupleManager::getInstance().fill();
         NtupleManager::getInstance().clear();
@@ -364,12 +774,13 @@ void Process::run() {
       delete outFile;
       outFile = nullptr;
     }
+    closeStreams();
 
   }  // are there input files? if-else tree
 
   // finally, notify everyone that we are stopping
   if (performance_) performance_->start(performance::Callback::onProcessEnd, 0);
-  i_proc = 0;
+  std::size_t i_proc{0};
   for (auto module : sequence_) {
     i_proc++;
     if (performance_)
@@ -380,18 +791,43 @@ void Process::run() {
   }
   if (performance_) performance_->stop(performance::Callback::onProcessEnd, 0);
 
-  // we're done so let's close up the logging
-  logging::close();
-  if (performance_) performance_->absolute_stop();
+  // all of the output files have been closed
+  implicitMT.reset();
+  threadPool_.reset();
+}
+
+std::function<void(std::size_t)> Process::withThreadEvent(
+    const std::function<void(std::size_t)> &fn) const {
+  const ldmx::EventHeader *header{threadEventHeader_};
+  StorageControl *storage{threadStorageController_};
+  return [&fn, header, storage](std::size_t i) {
+    // the thread may be in the middle of another event, e.g. while it
+    // waits for its own tasks, so we put that one back afterwards
+    const ldmx::EventHeader *previousHeader{threadEventHeader_};
+    StorageControl *previousStorage{threadStorageController_};
+    threadEventHeader_ = header;
+    threadStorageController_ = storage;
+    try {
+      fn(i);
+    } catch (...) {
+      threadEventHeader_ = previousHeader;
+      threadStorageController_ = previousStorage;
+      throw;
+    }
+    threadEventHeader_ = previousHeader;
+    threadStorageController_ = previousStorage;
+  };
 }
 
 int Process::getRunNumber() const {
-  return (eventHeader_) ? (eventHeader_->getRun()) : (runForGeneration_);
+  const ldmx::EventHeader *header{getEventHeader()};
+  return (header) ? (header->getRun()) : (runForGeneration_);
 }
 
 TDirectory *Process::makeHistoDirectory(const std::string &dirName) {
   auto owner{openHistoFile()};
-  TDirectory *child = owner->mkdir((char *)dirName.c_str());
+  TDirectory *child = owner->GetDirectory(dirName.c_str());
+  if (not child) child = owner->mkdir((char *)dirName.c_str());
   if (child) child->cd();
   return child;
 }
@@ -417,17 +853,200 @@ TDirectory *Process::openHistoFile() {
   return owner;
 }
 
+bool Process::startWorkers() {
+  if (inputFiles_.empty()) {
+    ldmx_log(warn) << "Worker processes split the input files between them "
+                      "and there are none, producing events in this process.";
+    return false;
+  }
+  if (outputFiles_.size() > 1 and outputFiles_.size() != inputFiles_.size()) {
+    EXCEPTION_RAISE("Process",
+                    "Unable to handle case of different number of input and "
+                    "output files (other than zero/one ouput file).");
+  }
+
+  // The event limit is for all of the workers together. We only hand out
+  // the files with the events a single process would have processed and
+  // each worker gets the number of those events in its files.
+  std::vector<int> fileEvents;
+  if (eventLimit_ > 0) {
+    int remaining{eventLimit_};
+    while (fileEvents.size() < inputFiles_.size() and remaining > 0) {
+      EventFile file(config_, inputFiles_[fileEvents.size()]);
+      fileEvents.push_back(
+          int(std::min<Long64_t>(file.getEntries(), remaining)));
+      remaining -= fileEvents.back();
+    }
+    inputFiles_.resize(fileEvents.size());
+    if (outputFiles_.size() > 1) outputFiles_.resize(fileEvents.size());
+  }
+
+  int n_workers{std::min(numWorkers_, int(inputFiles_.size()))};
+  // don't let the workers inherit output that hasn't been written yet
+  // nor the logging threads, which wouldn't exist in them
+  logging::suspend();
+  std::cout.flush();
+  std::fflush(nullptr);
+  for (int worker{0}; worker < n_workers; worker++) {
+    pid_t pid{fork()};
+    if (pid < 0) {
+      EXCEPTION_RAISE("Worker", "Unable to start worker process " +
+                                    std::to_string(worker) + ": " +
+                                    std::strerror(errno));
+    } else if (pid == 0) {
+      logging::resume();
+      int limit{-1};
+      if (eventLimit_ > 0) {
+        auto [begin, end] = workerBlock(fileEvents.size(), worker, n_workers);
+        limit = std::accumulate(fileEvents.begin() + begin,
+                                fileEvents.begin() + end, 0);
+      }
+      becomeWorker(worker, n_workers, limit);
+      return false;
+    }
+    workerPids_.push_back(pid);
+  }
+  logging::resume();
+  ldmx_log(info) << "Started " << n_workers << " worker processes";
+  return true;
+}
+
+void Process::becomeWorker(int worker, int n_workers, int eventLimit) {
+  workerPids_.clear();
+  worker_ = worker;
+  eventLimit_ = eventLimit;
+
+  auto block = [&](const std::vector<std::string> &files) {
+    auto [begin, end] = workerBlock(files.size(), worker, n_workers);
+    return std::vector<std::string>(files.begin() + begin,
+                                    files.begin() + end);
+  };
+  if (outputFiles_.size() == 1) {
+    outputFiles_[0] = workerFileName(outputFiles_[0], worker);
+  } else {
+    outputFiles_ = block(outputFiles_);
+  }
+  inputFiles_ = block(inputFiles_);
+  for (auto &stream : outputStreams_)
+    stream->fileName = workerFileName(stream->fileName, worker);
+  ldmx_log(info) << "Worker " << worker << " processing "
+                 << inputFiles_.size() << " input files";
+
+  if (histoFilename_.empty()) return;
+  histoFilename_ = workerFileName(histoFilename_, worker);
+  if (histoTFile_) {
+    // The histogram file is shared with the parent, so we move what was
+    // booked into a file of our own and forget about the shared one
+    // without writing or closing it.
+    TFile *shared{histoTFile_};
+    gROOT->GetListOfFiles()->Remove(shared);
+    histoTFile_ = new TFile(histoFilename_.c_str(), "RECREATE");
+    moveContents(shared, histoTFile_);
+    for (auto module : sequence_) module->resetHistoDirectory();
+  }
+}
+
+void Process::finishWorker(Event &theEvent) {
+  int status{EXIT_SUCCESS};
+  try {
+    processEvents(theEvent);
+    // the process is never destructed, so we write what it would have
+    if (histoTFile_) {
+      histoTFile_->Write();
+      histoTFile_->Close();
+    }
+  } catch (const std::exception &e) {
+    ldmx_log(fatal) << "Worker " << worker_ << " failed: " << e.what();
+    status = EXIT_FAILURE;
+  } catch (...) {
+    ldmx_log(fatal) << "Worker " << worker_ << " failed";
+    status = EXIT_FAILURE;
+  }
+  logging::close();
+  std::cout.flush();
+  std::fflush(nullptr);
+  std::_Exit(status);
+}
+
+void Process::mergeWorkers() {
+  int n_failed{0};
+  for (std::size_t worker{0}; worker < workerPids_.size(); worker++) {
+    int status{0};
+    if (waitpid(workerPids_[worker], &status, 0) < 0 or
+        not WIFEXITED(status) or WEXITSTATUS(status) != 0) {
+      ldmx_log(error) << "Worker process " << worker << " failed";
+      n_failed++;
+    }
+  }
+  int n_workers{int(workerPids_.size())};
+  workerPids_.clear();
+
+  // the temporary files the workers wrote for the input name
+  auto parts = [&](const std::string &name) {
+    std::vector<std::string> files;
+    for (int worker{0}; worker < n_workers; worker++) {
+      std::string part{workerFileName(name, worker)};
+      // workers that didn't book anything don't write a histogram file
+      if (not gSystem->AccessPathName(part.c_str())) files.push_back(part);
+    }
+    return files;
+  };
+  std::vector<std::string> names;
+  if (outputFiles_.size() == 1) names.push_back(outputFiles_[0]);
+  for (const auto &stream : outputStreams_) names.push_back(stream->fileName);
+  if (not histoFilename_.empty()) names.push_back(histoFilename_);
+
+  if (n_failed > 0) {
+    // what the other workers wrote is incomplete without the failed ones
+    for (const auto &name : names)
+      for (const auto &part : parts(name)) gSystem->Unlink(part.c_str());
+    EXCEPTION_RAISE("Worker", std::to_string(n_failed) + " of " +
+                                  std::to_string(n_workers) +
+                                  " worker processes failed.");
+  }
+
+  auto merge = [&](const std::string &name) {
+    TFileMerger merger(false, false);
+    merger.SetPrintLevel(0);
+    if (not merger.OutputFile(name.c_str(), "RECREATE", compressionSetting_)) {
+      EXCEPTION_RAISE("Worker", "Unable to create merged file " + name);
+    }
+    auto files{parts(name)};
+    for (const auto &part : files) merger.AddFile(part.c_str(), false);
+    if (not merger.Merge()) {
+      EXCEPTION_RAISE("Worker", "Unable to merge the outputs of the workers "
+                                "into " + name);
+    }
+    for (const auto &part : files) gSystem->Unlink(part.c_str());
+    ldmx_log(info) << "Merged " << files.size() << " worker files into "
+                   << name;
+  };
+
+  if (outputFiles_.size() == 1) merge(outputFiles_[0]);
+  for (const auto &stream : outputStreams_) merge(stream->fileName);
+  if (not histoFilename_.empty()) {
+    // what we booked was copied into the workers, our own file
+    // would only overwrite their merged histograms
+    if (histoTFile_) {
+      // the processors may still point to what was booked, keep it in memory
+      histoTFile_->Close("nodelete");
+      histoTFile_ = nullptr;
+    }
+    merge(histoFilename_);
+  }
+}
+
 void Process::newRun(ldmx::RunHeader &header) {
   // Producers are allowed to put parameters into
   // the run header through 'beforeNewRun' method
   if (performance_) performance_->start(performance::Callback::beforeNewRun, 0);
   std::size_t i_proc{0};
-  for (auto module : sequence_) {
+  for (const auto &step : plan_) {
     i_proc++;
-    if (dynamic_cast<Producer *>(module)) {
+    if (step.producer) {
       if (performance_)
         performance_->start(performance::Callback::beforeNewRun, i_proc);
-      dynamic_cast<Producer *>(module)->beforeNewRun(header);
+      step.producer->beforeNewRun(header);
       if (performance_)
         performance_->stop(performance::Callback::beforeNewRun, i_proc);
     }
@@ -449,7 +1068,7 @@ void Process::newRun(ldmx::RunHeader &header) {
   if (performance_) performance_->stop(performance::Callback::onNewRun, 0);
 }
 
-bool Process::process(int n, Event &event) const {
+bool Process::process(int n, Event &event) {
   if ((logFrequency_ != -1) && ((n + 1) % logFrequency_ == 0)) {
     TTimeStamp t;
     ldmx_log(info) << "Processing " << n + 1 << " Run "
@@ -459,23 +1078,33 @@ bool Process::process(int n, Event &event) const {
   }
 
   if (performance_) performance_->start(performance::Callback::process, 0);
-  std::size_t i_proc{0};
   try {
-    for (auto module : sequence_) {
-      i_proc++;
-      if (performance_)
-        performance_->start(performance::Callback::process, i_proc);
-      if (dynamic_cast<Producer *>(module)) {
-        (dynamic_cast<Producer *>(module))->produce(event);
-      } else if (dynamic_cast<Analyzer *>(module)) {
-        (dynamic_cast<Analyzer *>(module))->analyze(event);
+    if (threadPool_) {
+      for (const auto &level : levels_) {
+        ThreadPool::TaskGroup group(*threadPool_);
+        for (std::size_t i_proc : level) {
+          if (skipProcessor(i_proc)) continue;
+          group.run([this, i_proc, &event]() {
+            // conditions are pinned by the thread that requested them and
+            // this thread may be waiting in another processor's parallelFor
+            std::size_t mark{conditions_.pinMark()};
+            runProcessor(i_proc, event);
+            conditions_.releaseSince(mark);
+          });
+        }
+        group.wait();
       }
-      if (performance_)
-        performance_->stop(performance::Callback::process, i_proc);
+    } else if (performance_ or earlyReject_) {
+      for (std::size_t i_proc{0}; i_proc < sequence_.size(); i_proc++) {
+        if (skipProcessor(i_proc)) continue;
+        runProcessor(i_proc, event);
+      }
+    } else {
+      // nothing to measure or skip, just go through the plan
+      for (const auto &step : plan_) step.call(step.module, event);
     }
   } catch (AbortEventException &) {
     if (performance_) {
-      performance_->stop(performance::Callback::process, i_proc);
       performance_->stop(performance::Callback::process, 0);
       performance_->end_event(false);
     }
@@ -488,6 +1117,239 @@ bool Process::process(int n, Event &event) const {
   return true;
 }
 
+bool Process::skipProcessor(std::size_t i_proc) const {
+  if (earlyReject_ and outputOnly_[i_proc] and isRejected()) {
+    // this event won't be stored so there is no reason to run
+    // the processors that only matter for the output
+    if (performance_) performance_->skip(i_proc + 1);
+    return true;
+  }
+  return false;
+}
+
+void Process::runProcessor(std::size_t i_proc, Event &event) const {
+  // the performance tracker reserves index zero for the whole sequence
+  if (performance_)
+    performance_->start(performance::Callback::process, i_proc + 1);
+  try {
+    callProcessor(i_proc, event);
+  } catch (AbortEventException &) {
+    if (performance_)
+      performance_->stop(performance::Callback::process, i_proc + 1);
+    throw;
+  }
+  if (performance_)
+    performance_->stop(performance::Callback::process, i_proc + 1);
+}
+
+void Process::callProcessor(std::size_t i_proc, Event &event) const {
+  const Step &step{plan_[i_proc]};
+  step.call(step.module, event);
+}
+
+bool Process::isRejected() const {
+  if (not storageController_.isRejected()) return false;
+  for (const auto &stream : outputStreams_) {
+    if (not stream->storage.isRejected()) return false;
+  }
+  return true;
+}
+
+void Process::addStorageHint(const std::string &processor,
+                             StorageControl::Hint hint,
+                             const std::string &purpose) {
+  getStorageController().addHint(processor, hint, purpose);
+  for (auto &stream : outputStreams_)
+    stream->storage.addHint(processor, hint, purpose);
+}
+
+void Process::openStreams(Event &theEvent, EventFile *parent,
+                          ldmx::RunHeader *runHeader) {
+  for (auto &stream : outputStreams_) {
+    if (stream->file) {
+      // the streams are single output files over all input files
+      stream->file->updateParent(parent);
+      continue;
+    }
+    ldmx_log(info) << "Writing output stream '" << stream->name << "' to "
+                   << stream->fileName;
+    stream->file =
+        new EventFile(config_, stream->fileName, parent, true, true, false);
+    for (const auto &rule : stream->dropKeepRules) stream->file->addDrop(rule);
+    stream->file->setupStream(&theEvent);
+    if (runHeader) stream->file->writeRunHeader(*runHeader);
+  }
+}
+
+void Process::fillStreams(bool completed) {
+  for (auto &stream : outputStreams_) {
+    stream->file->fillStream(stream->storage.keepEvent(completed));
+    // ready for the hints of the next event
+    stream->storage.resetEventState();
+  }
+}
+
+void Process::closeStreams() {
+  for (auto &stream : outputStreams_) {
+    if (not stream->file) continue;
+    stream->file->writeRunTree();
+    delete stream->file;
+    stream->file = nullptr;
+  }
+}
+
+void Process::configureStorage(StorageControl &storage) const {
+  storage.setDefaultKeep(skimDefaultIsKeep_);
+  for (std::size_t i = 0; i + 1 < skimRules_.size(); i += 2) {
+    storage.addRule(skimRules_[i], skimRules_[i + 1]);
+  }
+}
+
+int Process::runPipeline(EventFile &outFile, Event &theEvent) {
+  std::size_t n_stages{pipelineStages_.size()};
+  std::vector<std::size_t> stageBegin{0};
+  for (int n : pipelineStages_) stageBegin.push_back(stageBegin.back() + n);
+
+  if (performance_) {
+    ldmx_log(warn) << "Processor timing is not tracked event-by-event "
+                      "while running a pipeline.";
+  }
+  // the stages may use ROOT from several threads
+  ROOT::EnableThreadSafety();
+  ldmx_log(info) << "Running the sequence in " << n_stages
+                 << " pipeline stages with " << pipelineDepth_
+                 << " events in flight";
+
+  // stop everything if any of the threads fails
+  std::atomic<bool> failed{false};
+  std::vector<std::exception_ptr> errors(n_stages);
+
+  // queue i feeds stage i and the last queue feeds the output,
+  //  the output hands the events back to the first stage for reuse
+  std::vector<std::unique_ptr<PipelineQueue>> queues;
+  for (std::size_t i{0}; i <= n_stages; i++)
+    queues.push_back(
+        std::make_unique<PipelineQueue>(std::size_t(pipelineDepth_), failed));
+  std::vector<std::unique_ptr<PipelineSlot>> slots;
+  for (int i{0}; i < pipelineDepth_; i++) {
+    slots.push_back(std::make_unique<PipelineSlot>(passname_));
+    configureStorage(slots.back()->storage);
+    queues[0]->push(slots.back().get());
+  }
+  auto fail = [&]() {
+    failed = true;
+    for (auto &queue : queues) queue->interrupt();
+  };
+
+  // the first stage also starts the events, a null slot ends the pipeline
+  int n_started{0};
+  auto stage = [&](std::size_t i_stage) {
+    try {
+      PipelineSlot *slot{nullptr};
+      do {
+        if (not queues[i_stage]->pop(slot)) return;
+        if (i_stage == 0) {
+          if (n_started < eventLimit_) {
+            n_started++;
+            ldmx::EventHeader &eh = slot->event.getEventHeader();
+            eh.setRun(runForGeneration_);
+            eh.setEventNumber(n_started);
+            eh.setTimestamp(TTimeStamp());
+            slot->storage.resetEventState();
+            slot->completed = true;
+          } else {
+            slot = nullptr;
+          }
+        }
+        if (slot and slot->completed) {
+          threadEventHeader_ = slot->event.getEventHeaderPtr();
+          threadStorageController_ = &slot->storage;
+          try {
+            for (std::size_t i_proc{stageBegin[i_stage]};
+                 i_proc < stageBegin[i_stage + 1]; i_proc++) {
+              if (earlyReject_ and outputOnly_[i_proc] and
+                  slot->storage.isRejected())
+                continue;
+              callProcessor(i_proc, slot->event);
+            }
+          } catch (AbortEventException &) {
+            slot->completed = false;
+          }
+          conditions_.onEndOfEvent();
+          threadEventHeader_ = nullptr;
+          threadStorageController_ = nullptr;
+        }
+        if (not queues[i_stage + 1]->push(slot)) return;
+      } while (slot);
+    } catch (...) {
+      errors[i_stage] = std::current_exception();
+      fail();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (std::size_t i{0}; i < n_stages; i++) threads.emplace_back(stage, i);
+
+  int n_events{0};
+  std::exception_ptr error;
+  try {
+    PipelineSlot *slot{nullptr};
+    while (queues[n_stages]->pop(slot) and slot) {
+      if ((logFrequency_ != -1) && ((n_events + 1) % logFrequency_ == 0)) {
+        TTimeStamp t;
+        ldmx_log(info) << "Processing " << n_events + 1 << " Run "
+                       << slot->event.getEventHeader().getRun() << " Event "
+                       << slot->event.getEventHeader().getEventNumber()
+                       << "  (" << t.AsString("lc") << ")";
+      }
+      // events leave the last stage in the order they were started
+      theEvent.takeProducts(slot->event);
+      outFile.nextEvent(slot->storage.keepEvent(slot->completed));
+      n_events++;
+      if (not queues[0]->push(slot)) break;
+    }
+  } catch (...) {
+    error = std::current_exception();
+    fail();
+  }
+
+  for (auto &thread : threads) thread.join();
+  if (error) std::rethrow_exception(error);
+  for (auto &e : errors) {
+    if (e) std::rethrow_exception(e);
+  }
+  return n_events;
+}
+
+std::vector<std::vector<std::size_t>> Process::makeLevels(
+    const std::vector<EventProcessor *> &sequence) {
+  std::vector<std::vector<std::size_t>> levels;
+  std::vector<std::size_t> level(sequence.size(), 0);
+  for (std::size_t i{0}; i < sequence.size(); i++) {
+    for (std::size_t j{0}; j < i; j++) {
+      if (dependsOn(*sequence[i], *sequence[j]))
+        level[i] = std::max(level[i], level[j] + 1);
+    }
+    if (level[i] >= levels.size()) levels.resize(level[i] + 1);
+    levels[level[i]].push_back(i);
+  }
+  return levels;
+}
+
+void Process::schedule() {
+  levels_ = makeLevels(sequence_);
+
+  ldmx_log(info) << "Running " << sequence_.size() << " processors in "
+                 << levels_.size() << " levels on " << numThreads_
+                 << " threads";
+  for (std::size_t i_level{0}; i_level < levels_.size(); i_level++) {
+    std::stringstream names;
+    for (std::size_t i_proc : levels_[i_level])
+      names << " " << sequence_[i_proc]->getName();
+    ldmx_log(debug) << "Level " << i_level << ":" << names.str();
+  }
+}
+
 void Process::onFileOpen(EventFile &file) const {
   if (performance_) performance_->start(performance::Callback::onFileOpen, 0);
   std::size_t i_proc{0};
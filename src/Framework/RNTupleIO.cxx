@@ -0,0 +1,196 @@
+#include "Framework/RNTupleIO.h"
+
+#include "Framework/Exception/Exception.h"
+#include "RVersion.h"
+#include "TFile.h"
+
+/**
+ * RNTuple left the experimental namespace with ROOT 6.36 and the
+ * interface we use (raw-pointer binding of entries and views) is
+ * only available since ROOT 6.34, so we only compile the backend
+ * if ROOT is new enough.
+ */
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 34, 0)
+#define FRAMEWORK_HAS_RNTUPLE
+#include <ROOT/REntry.hxx>
+#include <ROOT/RField.hxx>
+#include <ROOT/RNTupleModel.hxx>
+#include <ROOT/RNTupleReader.hxx>
+#include <ROOT/RNTupleView.hxx>
+#include <ROOT/RNTupleWriteOptions.hxx>
+#include <ROOT/RNTupleWriter.hxx>
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 36, 0)
+namespace rntuple = ROOT;
+#else
+namespace rntuple = ROOT::Experimental;
+#endif
+#endif
+
+namespace framework {
+
+#ifdef FRAMEWORK_HAS_RNTUPLE
+
+struct RNTupleSink::Impl {
+  /// file we are writing to
+  TFile *file_;
+  /// name of the RNTuple
+  std::string name_;
+  /// compression setting for the RNTuple
+  int compression_;
+  /// model of fields, only used before the writer is created
+  std::unique_ptr<rntuple::RNTupleModel> model_;
+  /// the writer, created on the first fill
+  std::unique_ptr<rntuple::RNTupleWriter> writer_;
+  /// entry binding our addresses to the fields, reset when fields are added
+  std::unique_ptr<rntuple::REntry> entry_;
+  /// field names and the addresses they are read from
+  std::vector<std::pair<std::string, void *>> fields_;
+
+  /// create the writer, freezing the model
+  void createWriter() {
+    rntuple::RNTupleWriteOptions options;
+    options.SetCompression(compression_);
+    writer_ = rntuple::RNTupleWriter::Append(std::move(model_), name_, *file_,
+                                             options);
+  }
+};
+
+RNTupleSink::RNTupleSink(TFile *file, const std::string &name,
+                         int compression)
+    : impl_{std::make_unique<Impl>()} {
+  impl_->file_ = file;
+  impl_->name_ = name;
+  impl_->compression_ = compression;
+  impl_->model_ = rntuple::RNTupleModel::CreateBare();
+}
+
+RNTupleSink::~RNTupleSink() {
+  // make sure an RNTuple is written even if no events were filled
+  if (not impl_->writer_) impl_->createWriter();
+  // destructing the writer commits the data to the file
+  impl_->entry_.reset();
+  impl_->writer_.reset();
+}
+
+void RNTupleSink::addField(const std::string &name, const std::string &type,
+                           void *address) {
+  try {
+    auto field{rntuple::RFieldBase::Create(name, type).Unwrap()};
+    if (impl_->writer_) {
+      // we have already started writing, so we need to extend the model
+      auto updater{impl_->writer_->CreateModelUpdater()};
+      updater->BeginUpdate();
+      updater->AddField(std::move(field));
+      updater->CommitUpdate();
+      impl_->entry_.reset();
+    } else {
+      impl_->model_->AddField(std::move(field));
+    }
+  } catch (const std::exception &e) {
+    EXCEPTION_RAISE("RNTuple", "Unable to create field '" + name +
+                                   "' of type '" + type +
+                                   "' in the output RNTuple: " + e.what());
+  }
+  impl_->fields_.emplace_back(name, address);
+}
+
+void RNTupleSink::fill() {
+  if (not impl_->writer_) impl_->createWriter();
+  if (not impl_->entry_) {
+    impl_->entry_ = impl_->writer_->GetModel().CreateBareEntry();
+    for (auto &[name, address] : impl_->fields_)
+      impl_->entry_->BindRawPtr(name, address);
+  }
+  impl_->writer_->Fill(*impl_->entry_);
+}
+
+struct RNTupleSource::Impl {
+  /// the reader
+  std::unique_ptr<rntuple::RNTupleReader> reader_;
+  /// views of the fields that have been connected
+  std::vector<rntuple::RNTupleView<void>> views_;
+};
+
+RNTupleSource::RNTupleSource(const std::string &file_name,
+                             const std::string &name)
+    : impl_{std::make_unique<Impl>()} {
+  try {
+    impl_->reader_ = rntuple::RNTupleReader::Open(name, file_name);
+  } catch (const std::exception &e) {
+    EXCEPTION_RAISE("FileError", "Unable to open RNTuple '" + name +
+                                     "' in file '" + file_name +
+                                     "': " + e.what());
+  }
+}
+
+RNTupleSource::~RNTupleSource() = default;
+
+long long RNTupleSource::getEntries() const {
+  return impl_->reader_->GetNEntries();
+}
+
+std::vector<std::pair<std::string, std::string>> RNTupleSource::getFields()
+    const {
+  std::vector<std::pair<std::string, std::string>> fields;
+  const auto &descriptor{impl_->reader_->GetDescriptor()};
+  for (const auto &field : descriptor.GetTopLevelFields()) {
+    fields.emplace_back(field.GetFieldName(), field.GetTypeName());
+  }
+  return fields;
+}
+
+bool RNTupleSource::connect(const std::string &name, void *address) {
+  try {
+    impl_->views_.push_back(impl_->reader_->GetView<void>(name, address));
+  } catch (const std::exception &) {
+    return false;
+  }
+  if (entry_ >= 0) impl_->views_.back()(entry_);
+  return true;
+}
+
+void RNTupleSource::setEntry(long long entry) {
+  entry_ = entry;
+  for (auto &view : impl_->views_) view(entry_);
+}
+
+#else
+
+struct RNTupleSink::Impl {};
+
+RNTupleSink::RNTupleSink(TFile *, const std::string &, int) {
+  EXCEPTION_RAISE("RNTuple",
+                  "Writing an RNTuple requires ROOT >= 6.34, this build uses "
+                  "ROOT " ROOT_RELEASE ".");
+}
+
+RNTupleSink::~RNTupleSink() = default;
+
+void RNTupleSink::addField(const std::string &, const std::string &, void *) {}
+
+void RNTupleSink::fill() {}
+
+struct RNTupleSource::Impl {};
+
+RNTupleSource::RNTupleSource(const std::string &, const std::string &) {
+  EXCEPTION_RAISE("RNTuple",
+                  "Reading an RNTuple requires ROOT >= 6.34, this build uses "
+                  "ROOT " ROOT_RELEASE ".");
+}
+
+RNTupleSource::~RNTupleSource() = default;
+
+long long RNTupleSource::getEntries() const { return 0; }
+
+std::vector<std::pair<std::string, std::string>> RNTupleSource::getFields()
+    const {
+  return {};
+}
+
+bool RNTupleSource::connect(const std::string &, void *) { return false; }
+
+void RNTupleSource::setEntry(long long entry) { entry_ = entry; }
+
+#endif
+
+}  // namespace framework
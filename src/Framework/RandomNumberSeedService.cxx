@@ -15,6 +15,31 @@ static const int SEED_EXTERNAL = 2;
 static const int SEED_RUN = 3;
 static const int SEED_TIME = 4;
 
+namespace {
+
+/**
+ * Mix the bits of a 64-bit word (finalizer of splitmix64)
+ */
+uint64_t mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+  return x ^ (x >> 31);
+}
+
+/**
+ * Hash a name with 64-bit FNV-1a
+ */
+uint64_t hashName(const std::string& name) {
+  uint64_t hash{0xCBF29CE484222325};
+  for (unsigned char c : name) {
+    hash ^= c;
+    hash *= 0x100000001B3;
+  }
+  return hash;
+}
+
+}  // namespace
+
 void RandomNumberSeedService::stream(std::ostream& s) const {
   s << "RandomNumberSeedService(";
   if (seedMode_ == SEED_RUN) s << "Seed on RUN";
@@ -70,6 +95,18 @@ uint64_t RandomNumberSeedService::getSeed(const std::string& name) const {
   return seed;
 }
 
+RandomStream RandomNumberSeedService::getEventStream(const std::string& name,
+                                                     int run,
+                                                     int event) const {
+  uint64_t key{mix(masterSeed_ ^ mix(hashName(name)))};
+  return RandomStream(key, uint32_t(event), uint32_t(run));
+}
+
+RandomStream RandomNumberSeedService::getEventStream(
+    const std::string& name, const ldmx::EventHeader& header) const {
+  return getEventStream(name, header.getRun(), header.getEventNumber());
+}
+
 std::vector<std::string> RandomNumberSeedService::getSeedNames() const {
   std::vector<std::string> rv;
   for (auto i : seeds_) {
@@ -4,19 +4,60 @@
 
 namespace framework {
 
-void StorageControl::resetEventState() { hints_.clear(); }
+void StorageControl::resetEventState() {
+  votesKeep_ = 0;
+  votesDrop_ = 0;
+  mustKeep_ = 0;
+  mustDrop_ = 0;
+}
 
 void StorageControl::addHint(const std::string& processor_name, Hint hint,
                              const std::string& purposeString) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (not isListening(processor_name, purposeString)) return;
+  // tally hints that matched a rule for the decision
+  switch (hint) {
+    case Hint::MustDrop:
+      mustDrop_++;
+      break;
+    case Hint::MustKeep:
+      mustKeep_++;
+      break;
+    case Hint::ShouldDrop:
+      votesDrop_++;
+      break;
+    case Hint::ShouldKeep:
+      votesKeep_++;
+      break;
+    case Hint::Undefined:
+    case Hint::NoOpinion:
+      break;
+    default:
+      // how did I get here?
+      EXCEPTION_RAISE(
+          "SupaBad",
+          "This error comes from StorageControl and should never happen. "
+          "A storage hint should always be one of the members of the "
+          "StorageControlHint enum.");
+  }
+}
+
+bool StorageControl::isListening(const std::string& processor_name,
+                                 const std::string& purposeString) {
+  auto& purposes{listening_[processor_name]};
+  auto decision{purposes.find(purposeString)};
+  if (decision != purposes.end()) return decision->second;
+
+  bool listen{false};
   for (const auto& [processor_rule, purpose_rule] : rules_) {
     if (std::regex_match(processor_name, processor_rule) and
         std::regex_match(purposeString, purpose_rule)) {
-      // cache hints that matched a rule for later tallying
-      hints_.push_back(hint);
-      // leave after first match to avoid double-counting
+      listen = true;
       break;
     }
   }
+  purposes.emplace(purposeString, listen);
+  return listen;
 }
 
 void StorageControl::addRule(const std::string& processor_pat,
@@ -26,6 +67,9 @@ void StorageControl::addRule(const std::string& processor_pat,
    */
   if (processor_pat.empty()) return;
 
+  // previous decisions may change with the new rule
+  listening_.clear();
+
   try {
     rules_.emplace_back(
         std::piecewise_construct,
@@ -50,54 +94,25 @@ bool StorageControl::keepEvent(bool event_completed) const {
   if (not event_completed) return false;
 
   /**
-   * loop over the hints provided by processors we are listening to.
-   */
-  int votesKeep(0), votesDrop(0);
-  bool mustDrop{false}, mustKeep{false};
-  for (auto hint : hints_) {
-    switch (hint) {
-      case Hint::MustDrop:
-        mustDrop = true;
-        break;
-      case Hint::MustKeep:
-        mustKeep = true;
-        break;
-      case Hint::ShouldDrop:
-        votesDrop++;
-        break;
-      case Hint::ShouldKeep:
-        votesKeep++;
-        break;
-      case Hint::Undefined:
-      case Hint::NoOpinion:
-        break;
-      default:
-        // how did I get here?
-        EXCEPTION_RAISE(
-            "SupaBad",
-            "This error comes from StorageControl and should never happen. "
-            "A storage hint should always be one of the members of the "
-            "StorageControlHint enum.");
-    }
-  }
-
-  /**
+   * The hints provided by processors we are listening to
+   * have already been tallied as they were added.
+   *
    * mustDrop is highest priority, if it exists the event is dropped
    */
-  if (mustDrop) return false;
+  if (mustDrop_ > 0) return false;
 
   /**
    * mustKeep is second highest, if it exists when mustDrop does not, the event
    * is kept
    */
-  if (mustKeep) return true;
+  if (mustKeep_ > 0) return true;
 
   /**
    * If we don't have any 'must' hints, we tally votes
    * and follow the choice made by a simple majority.
    */
-  if (votesKeep > votesDrop) return true;
-  if (votesDrop > votesKeep) return false;
+  if (votesKeep_ > votesDrop_) return true;
+  if (votesDrop_ > votesKeep_) return false;
 
   /**
    * If there is a tie in the vote (including the case
@@ -0,0 +1,107 @@
+#include "Framework/ThreadPool.h"
+
+#include <algorithm>
+
+namespace framework {
+
+ThreadPool::ThreadPool(std::size_t n_workers) {
+  workers_.reserve(n_workers);
+  for (std::size_t i{0}; i < n_workers; i++)
+    workers_.emplace_back([this]() { work(); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  available_.notify_all();
+  for (auto &worker : workers_) worker.join();
+}
+
+void ThreadPool::parallelFor(std::size_t begin, std::size_t end,
+                             const std::function<void(std::size_t)> &fn) {
+  if (end <= begin) return;
+  std::size_t n{end - begin};
+  std::size_t n_chunks{std::min(n, 4 * concurrency())};
+  TaskGroup group(*this);
+  for (std::size_t i_chunk{0}; i_chunk < n_chunks; i_chunk++) {
+    std::size_t chunk_begin{begin + n * i_chunk / n_chunks},
+        chunk_end{begin + n * (i_chunk + 1) / n_chunks};
+    group.run([chunk_begin, chunk_end, &fn]() {
+      for (std::size_t i{chunk_begin}; i < chunk_end; i++) fn(i);
+    });
+  }
+  group.wait();
+}
+
+bool ThreadPool::runOne(std::unique_lock<std::mutex> &lock) {
+  if (queue_.empty()) return false;
+  auto task{std::move(queue_.front())};
+  queue_.pop_front();
+  lock.unlock();
+  task();
+  lock.lock();
+  return true;
+}
+
+void ThreadPool::work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    available_.wait(lock, [this]() { return stop_ or not queue_.empty(); });
+    if (queue_.empty()) return;  // stopping and nothing left to do
+    runOne(lock);
+  }
+}
+
+ThreadPool::TaskGroup::~TaskGroup() {
+  try {
+    wait();
+  } catch (...) {
+    // the error was already ignored by whoever didn't wait
+  }
+}
+
+void ThreadPool::TaskGroup::run(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(pool_.mutex_);
+    pending_++;
+    pool_.queue_.emplace_back([this, task = std::move(task)]() {
+      std::exception_ptr error;
+      try {
+        task();
+      } catch (...) {
+        error = std::current_exception();
+      }
+      // the group may be gone as soon as pending_ drops to zero
+      ThreadPool &pool{pool_};
+      {
+        std::lock_guard<std::mutex> lock(pool.mutex_);
+        if (error and not error_) error_ = error;
+        pending_--;
+      }
+      pool.changed_.notify_all();
+    });
+  }
+  pool_.available_.notify_one();
+  pool_.changed_.notify_all();
+}
+
+void ThreadPool::TaskGroup::wait() {
+  std::unique_lock<std::mutex> lock(pool_.mutex_);
+  while (pending_ > 0) {
+    // help with the queued tasks (ours or not) instead of idling
+    if (not pool_.runOne(lock)) {
+      pool_.changed_.wait(lock, [this]() {
+        return pending_ == 0 or not pool_.queue_.empty();
+      });
+    }
+  }
+  if (error_) {
+    auto error{error_};
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace framework
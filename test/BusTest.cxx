@@ -0,0 +1,75 @@
+/**
+ * @file BusTest.cxx
+ * @brief Test keeping passengers of the event bus between files
+ */
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <vector>
+
+#include "Framework/Bus.h"
+
+namespace framework {
+namespace test {
+
+/**
+ * Board a passenger as if its branch was read from a file
+ *
+ * @param[in] bus bus to board the passenger on
+ * @param[in] name name of the passenger
+ * @returns capacity the baggage of the passenger had before filling it
+ */
+static std::size_t boardAndFill(Bus& bus, const std::string& name) {
+  bus.board<std::vector<int>>(name);
+  std::size_t capacity{bus.get<std::vector<int>>(name).capacity()};
+  bus.update(name, std::vector<int>(100, 1));
+  return capacity;
+}
+
+}  // namespace test
+}  // namespace framework
+
+/**
+ * Test for parking the passengers of the Bus between files
+ *
+ * Passengers parked at the end of a file keep the memory their
+ * baggage holds if they board again in the next file, which we see
+ * from the capacity of the vectors they carry. Passengers that are
+ * not needed in the next file are dropped once it ends, so switching
+ * between files with different branches doesn't keep all of them.
+ */
+TEST_CASE("Bus Parking", "[Framework][functionality]") {
+  using framework::test::boardAndFill;
+  framework::Bus bus;
+
+  // first file has branches A and B
+  CHECK(boardAndFill(bus, "A_pass") == 0);
+  CHECK(boardAndFill(bus, "B_pass") == 0);
+  bus.parkEverybody();
+  // parking again before the next file starts doesn't drop anybody
+  bus.parkEverybody();
+  CHECK_FALSE(bus.isOnBoard("A_pass"));
+
+  SECTION("Passengers of the same file board again") {
+    CHECK(boardAndFill(bus, "A_pass") >= 100);
+    CHECK(boardAndFill(bus, "B_pass") >= 100);
+  }
+
+  SECTION("Switching between files with different branches") {
+    // second file only has branches B and C
+    CHECK(boardAndFill(bus, "B_pass") >= 100);
+    CHECK(boardAndFill(bus, "C_pass") == 0);
+    bus.parkEverybody();
+
+    // back to the first file, A was not needed by the second file
+    CHECK(boardAndFill(bus, "A_pass") == 0);
+    CHECK(boardAndFill(bus, "B_pass") >= 100);
+    bus.parkEverybody();
+
+    // and to the second file again, C was not needed by the first file
+    CHECK(boardAndFill(bus, "B_pass") >= 100);
+    CHECK(boardAndFill(bus, "C_pass") == 0);
+  }
+
+  bus.everybodyOff();
+}
@@ -0,0 +1,178 @@
+/**
+ * @file ConditionsDiskCacheTest.cxx
+ * @brief Test the on-disk cache of conditions objects
+ */
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <string>
+
+#include "Framework/ConditionsDiskCache.h"
+#include "Framework/ConditionsObjectProvider.h"
+#include "Framework/ConfigCache.h"
+#include "Framework/EventHeader.h"
+#include "Framework/Process.h"
+#include "TSystem.h"
+
+namespace framework {
+namespace test {
+
+/**
+ * A conditions object holding a single number
+ */
+class CachedNumber : public ConditionsObject {
+ public:
+  CachedNumber(int value) : ConditionsObject("CachedNumber"), value_{value} {}
+  int value_;
+};
+
+/**
+ * A provider of numbers which serializes them itself
+ *
+ * The number depends on the parameters of the provider, which is what
+ * the cache needs to tell apart. The provider opts into caching unless
+ * its 'cache' parameter is false.
+ */
+class CachedNumberProvider : public ConditionsObjectProvider {
+ public:
+  CachedNumberProvider(const framework::config::Parameters& params,
+                       Process& process)
+      : ConditionsObjectProvider("CachedNumber", "Default", params, process),
+        value_{params.getParameter<int>("value")},
+        cache_{params.getParameter<bool>("cache", true)} {}
+
+  bool allowsDiskCache() const final override { return cache_; }
+
+  std::pair<const ConditionsObject*, ConditionsIOV> getCondition(
+      const ldmx::EventHeader&) final override {
+    return std::make_pair(new CachedNumber(value_), ConditionsIOV(1, 10));
+  }
+
+  bool writeConditionsObject(const ConditionsObject* co,
+                             std::string& buffer) const final override {
+    int value{dynamic_cast<const CachedNumber*>(co)->value_};
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    return true;
+  }
+
+  const ConditionsObject* readConditionsObject(
+      const char* buffer, std::size_t size) const final override {
+    if (size != sizeof(int)) return nullptr;
+    int value;
+    std::memcpy(&value, buffer, sizeof(value));
+    return new CachedNumber(value);
+  }
+
+ private:
+  int value_;
+  bool cache_;
+};
+
+}  // namespace test
+}  // namespace framework
+
+/**
+ * Test for ConditionsDiskCache
+ *
+ * We put an object into the cache and read it back with a provider
+ * configured the same way. A provider with the same name and tag but
+ * different parameters should not find it. Events outside of the IOV
+ * of the object should not find it either. Providers that don't opt
+ * into caching or whose parameters can't be hashed are never cached.
+ */
+TEST_CASE("Conditions Disk Cache", "[Framework][functionality]") {
+  using framework::test::CachedNumber;
+  using framework::test::CachedNumberProvider;
+
+  std::string directory{"conditions_disk_cache_test"};
+  gSystem->Exec(("rm -rf " + directory).c_str());
+  // for the providers which shouldn't write anything
+  std::string empty_directory{"conditions_disk_cache_test_empty"};
+  gSystem->Exec(("rm -rf " + empty_directory).c_str());
+
+  framework::config::Parameters empty;
+  framework::Process process(empty);
+
+  framework::config::Parameters params;
+  params.setParameters({{"className", std::string("CachedNumberProvider")},
+                        {"value", 7}});
+  framework::config::Parameters other_params;
+  other_params.setParameters(
+      {{"className", std::string("CachedNumberProvider")}, {"value", 8}});
+
+  CachedNumberProvider provider(params, process);
+  CachedNumberProvider same_provider(params, process);
+  CachedNumberProvider other_provider(other_params, process);
+  CHECK(framework::config::hashParameters(provider.getParameters()) ==
+        framework::config::hashParameters(same_provider.getParameters()));
+  CHECK(framework::config::hashParameters(provider.getParameters()) !=
+        framework::config::hashParameters(other_provider.getParameters()));
+
+  framework::ConditionsDiskCache cache(directory);
+
+  ldmx::EventHeader header;
+  header.setRun(5);
+  CHECK(cache.get("CachedNumber", provider, header).first == nullptr);
+
+  auto cond{provider.getCondition(header)};
+  cache.put("CachedNumber", provider, cond.first, cond.second);
+  provider.releaseConditionsObject(cond.first);
+
+  SECTION("Read back with the same parameters") {
+    auto cached{cache.get("CachedNumber", same_provider, header)};
+    REQUIRE(cached.first != nullptr);
+    CHECK(dynamic_cast<const CachedNumber*>(cached.first)->value_ == 7);
+    CHECK(cached.second.getFirstRun() == 1);
+    CHECK(cached.second.getLastRun() == 10);
+    same_provider.releaseConditionsObject(cached.first);
+  }
+
+  SECTION("Miss with other parameters") {
+    CHECK(cache.get("CachedNumber", other_provider, header).first == nullptr);
+  }
+
+  SECTION("Miss outside of the IOV") {
+    header.setRun(11);
+    CHECK(cache.get("CachedNumber", provider, header).first == nullptr);
+  }
+
+  SECTION("Providers not opting in are not cached") {
+    framework::config::Parameters uncached_params;
+    uncached_params.setParameters(
+        {{"className", std::string("CachedNumberProvider")},
+         {"value", 9},
+         {"cache", false}});
+    CachedNumberProvider uncached(uncached_params, process);
+    auto uncached_cond{uncached.getCondition(header)};
+    framework::ConditionsDiskCache empty_cache(empty_directory);
+    empty_cache.put("CachedNumber", uncached, uncached_cond.first,
+                    uncached_cond.second);
+    uncached.releaseConditionsObject(uncached_cond.first);
+    CHECK(empty_cache.get("CachedNumber", uncached, header).first == nullptr);
+    // nothing was written
+    CHECK(gSystem->AccessPathName(empty_directory.c_str()));
+  }
+
+  SECTION("Parameters that can't be hashed turn caching off") {
+    // the configuration cache doesn't write floats
+    framework::config::Parameters float_params;
+    float_params.setParameters(
+        {{"className", std::string("CachedNumberProvider")},
+         {"value", 10},
+         {"scale", 1.5f}});
+    CachedNumberProvider float_provider(float_params, process);
+    CHECK_THROWS(
+        framework::config::hashParameters(float_provider.getParameters()));
+    auto float_cond{float_provider.getCondition(header)};
+    framework::ConditionsDiskCache empty_cache(empty_directory);
+    CHECK_NOTHROW(empty_cache.put("CachedNumber", float_provider,
+                                  float_cond.first, float_cond.second));
+    float_provider.releaseConditionsObject(float_cond.first);
+    CHECK(empty_cache.get("CachedNumber", float_provider, header).first ==
+          nullptr);
+    CHECK(gSystem->AccessPathName(empty_directory.c_str()));
+  }
+
+  gSystem->Exec(("rm -rf " + directory).c_str());
+  gSystem->Exec(("rm -rf " + empty_directory).c_str());
+}
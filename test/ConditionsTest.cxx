@@ -0,0 +1,222 @@
+/**
+ * @file ConditionsTest.cxx
+ * @brief Test the versions of conditions kept in the conditions cache
+ */
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+#include "Framework/Conditions.h"
+#include "Framework/ConditionsObjectProvider.h"
+#include "Framework/EventHeader.h"
+#include "Framework/Process.h"
+#include "Framework/RunHeader.h"
+
+namespace framework {
+namespace test {
+
+/// Number of objects made by the RunNumberProvider
+static int n_loads{0};
+
+/// Number of objects given back to the RunNumberProvider
+static int n_releases{0};
+
+/// Number of objects made before the provider was told about their run
+static int n_early_loads{0};
+
+/**
+ * A conditions object holding the run it is valid for
+ */
+class RunNumber : public ConditionsObject {
+ public:
+  RunNumber(const std::string& name, int run)
+      : ConditionsObject(name), run_{run} {}
+  int run_;
+};
+
+/**
+ * A provider making a new object for each run
+ *
+ * It counts how many objects it made and how many were given back,
+ * so we can tell when the cache loads or releases a version. Objects
+ * made for a run before onNewRun was called for it were prefetched.
+ */
+class RunNumberProvider : public ConditionsObjectProvider {
+ public:
+  RunNumberProvider(const std::string& name, const std::string& tagname,
+                    const framework::config::Parameters& params,
+                    Process& process)
+      : ConditionsObjectProvider(name, tagname, params, process) {}
+
+  std::pair<const ConditionsObject*, ConditionsIOV> getCondition(
+      const ldmx::EventHeader& context) final override {
+    n_loads++;
+    if (context.getRun() != run_) n_early_loads++;
+    return std::make_pair(
+        new RunNumber(getConditionObjectName(), context.getRun()),
+        ConditionsIOV(context.getRun(), context.getRun()));
+  }
+
+  void releaseConditionsObject(const ConditionsObject* co) final override {
+    n_releases++;
+    delete co;
+  }
+
+  void onNewRun(ldmx::RunHeader& rh) final override {
+    run_ = rh.getRunNumber();
+  }
+
+ private:
+  /// run of the last call to onNewRun
+  int run_{0};
+};
+
+}  // namespace test
+}  // namespace framework
+
+DECLARE_CONDITIONS_PROVIDER_NS(framework::test, RunNumberProvider)
+
+/**
+ * Test for the versions kept by Conditions
+ *
+ * Each run has its own version of the condition. Up to the cache depth
+ * of them are kept alive at once, so going back to a run that is still
+ * cached doesn't load it again. Versions pinned by an event are only
+ * released once the event (or the part of it marked with pinMark) is
+ * done with them, even if they are beyond the cache depth. Prefetching
+ * the next run loads its version before the run starts, without loading
+ * it a second time once it does. Handles keep the object they got until
+ * the generation of the conditions changes.
+ */
+TEST_CASE("Conditions Cache", "[Framework][functionality]") {
+  using framework::test::n_early_loads;
+  using framework::test::n_loads;
+  using framework::test::n_releases;
+  using framework::test::RunNumber;
+
+  framework::config::Parameters empty;
+  framework::Process process(empty);
+  ldmx::EventHeader header;
+  process.setEventHeader(&header);
+
+  auto& conditions{process.getConditions()};
+  conditions.createConditionsObjectProvider(
+      "framework::test::RunNumberProvider", "RunNumber", "", empty);
+
+  n_loads = 0;
+  n_releases = 0;
+  n_early_loads = 0;
+  auto get = [&](int run) {
+    header.setRun(run);
+    return &conditions.getCondition<RunNumber>("RunNumber");
+  };
+
+  SECTION("Two versions are alive at once") {
+    auto run1{get(1)};
+    auto run2{get(2)};
+    conditions.onEndOfEvent();
+    CHECK(n_loads == 2);
+
+    // both are still cached
+    CHECK(get(1) == run1);
+    conditions.onEndOfEvent();
+    CHECK(get(2) == run2);
+    conditions.onEndOfEvent();
+    CHECK(get(2)->run_ == 2);
+    conditions.onEndOfEvent();
+    CHECK(n_loads == 2);
+    CHECK(n_releases == 0);
+
+    // a third run retires the version used the longest time ago
+    CHECK(get(3)->run_ == 3);
+    conditions.onEndOfEvent();
+    CHECK(n_loads == 3);
+    CHECK(n_releases == 1);
+    CHECK(get(2) == run2);
+    conditions.onEndOfEvent();
+    CHECK(n_loads == 3);
+    CHECK(get(1)->run_ == 1);
+    conditions.onEndOfEvent();
+    CHECK(n_loads == 4);
+  }
+
+  SECTION("A pinned version is not retired") {
+    conditions.setCacheDepth(1);
+    auto run1{get(1)};
+    CHECK(get(2)->run_ == 2);
+    // the first version is retired but the event still uses it
+    CHECK(n_releases == 0);
+    CHECK(run1->run_ == 1);
+    conditions.onEndOfEvent();
+    CHECK(n_releases == 1);
+    CHECK(get(1)->run_ == 1);
+    conditions.onEndOfEvent();
+    CHECK(n_loads == 3);
+  }
+
+  SECTION("Only the versions after the mark are released") {
+    conditions.setCacheDepth(1);
+    auto run1{get(1)};
+    std::size_t mark{conditions.pinMark()};
+    CHECK(get(2)->run_ == 2);
+    conditions.releaseSince(mark);
+    CHECK(conditions.pinMark() == mark);
+
+    // the third run releases the second, which isn't pinned anymore,
+    // but not the first, which is still pinned before the mark
+    CHECK(get(3)->run_ == 3);
+    CHECK(n_releases == 1);
+    CHECK(run1->run_ == 1);
+    conditions.onEndOfEvent();
+    CHECK(n_releases == 2);
+    CHECK(conditions.pinMark() == 0);
+  }
+
+  SECTION("Prefetching the next run loads each run once") {
+    conditions.require("RunNumber");
+    conditions.onProcessStart();
+    bool prefetch{true};
+    SECTION("with prefetching") { conditions.setPrefetchNextRun(true); }
+    SECTION("without prefetching") { prefetch = false; }
+
+    for (int run{1}; run <= 3; run++) {
+      header.setRun(run);
+      ldmx::RunHeader run_header(run);
+      conditions.onNewRun(run_header);
+      CHECK(get(run)->run_ == run);
+      conditions.onEndOfEvent();
+      conditions.prefetch(run + 1);
+    }
+    conditions.onProcessEnd();
+
+    // the prefetch of run 4 is loaded, but it never starts
+    CHECK(n_loads == (prefetch ? 4 : 3));
+    CHECK(n_early_loads == (prefetch ? 3 : 0));
+  }
+
+  SECTION("Handles look up again only in a new generation") {
+    framework::ConditionHandle<RunNumber> handle(conditions, "RunNumber");
+    header.setRun(1);
+    CHECK(handle->run_ == 1);
+    // loading the version started a new generation, so the handle
+    // looks it up once more and then keeps it
+    CHECK(handle->run_ == 1);
+    auto generation{conditions.generation()};
+    conditions.onEndOfEvent();
+
+    // the run changed but nothing told the handle to look again
+    header.setRun(2);
+    CHECK(handle->run_ == 1);
+    CHECK(conditions.generation() == generation);
+    CHECK(n_loads == 1);
+
+    // a new generation makes the handle look up the condition again
+    conditions.invalidate();
+    CHECK(handle->run_ == 2);
+    CHECK((*handle).run_ == 2);
+    CHECK(n_loads == 2);
+  }
+
+  conditions.onEndOfEvent();
+  process.setEventHeader(nullptr);
+}
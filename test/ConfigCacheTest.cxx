@@ -0,0 +1,80 @@
+/**
+ * @file ConfigCacheTest.cxx
+ * @brief Test the binary cache of the configuration
+ */
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <sstream>
+
+#include "Framework/ConfigCache.h"
+
+using framework::config::Parameters;
+
+/**
+ * Test for ConfigCache
+ *
+ * We write parameters holding every type ConfigurePython creates, read
+ * them back and check that they are the same. We also check that a cache
+ * written for one source is not used for another.
+ */
+TEST_CASE("Configuration Cache", "[Framework][functionality]") {
+  Parameters processor;
+  processor.setParameters(
+      {{"className", std::string("Producer")}, {"threshold", 2.5}});
+
+  Parameters config;
+  config.setParameters(
+      {{"maxEvents", 10},
+       {"skimDefaultIsKeep", true},
+       {"energy", 4.0},
+       {"passName", std::string("test")},
+       {"runs", std::vector<int>{1, 2, 3}},
+       {"weights", std::vector<double>{0.5, 1.5}},
+       {"inputFiles", std::vector<std::string>{"a.root", "b.root"}},
+       {"grid", std::vector<std::vector<int>>{{1}, {2, 3}}},
+       {"matrix", std::vector<std::vector<double>>{{1.}, {}}},
+       {"names", std::vector<std::vector<std::string>>{{"x", "y"}}},
+       {"logger", processor},
+       {"sequence", std::vector<Parameters>{processor, processor}},
+       {"nested", std::vector<std::vector<Parameters>>{{processor}}}});
+
+  std::stringstream buffer;
+  framework::config::writeParameters(buffer, config);
+  Parameters read{framework::config::readParameters(buffer)};
+
+  CHECK(read.getParameter<int>("maxEvents") == 10);
+  CHECK(read.getParameter<bool>("skimDefaultIsKeep"));
+  CHECK(read.getParameter<double>("energy") == 4.0);
+  CHECK(read.getParameter<std::string>("passName") == "test");
+  CHECK(read.getParameter<std::vector<int>>("runs") ==
+        std::vector<int>{1, 2, 3});
+  CHECK(read.getParameter<std::vector<double>>("weights") ==
+        std::vector<double>{0.5, 1.5});
+  CHECK(read.getParameter<std::vector<std::string>>("inputFiles") ==
+        std::vector<std::string>{"a.root", "b.root"});
+  CHECK(read.getParameter<std::vector<std::vector<int>>>("grid") ==
+        std::vector<std::vector<int>>{{1}, {2, 3}});
+  CHECK(read.getParameter<std::vector<std::vector<double>>>("matrix") ==
+        std::vector<std::vector<double>>{{1.}, {}});
+  CHECK(read.getParameter<std::vector<std::vector<std::string>>>("names") ==
+        std::vector<std::vector<std::string>>{{"x", "y"}});
+  CHECK(read.getParameter<Parameters>("logger")
+            .getParameter<std::string>("className") == "Producer");
+  auto sequence{read.getParameter<std::vector<Parameters>>("sequence")};
+  REQUIRE(sequence.size() == 2);
+  CHECK(sequence[1].getParameter<double>("threshold") == 2.5);
+  auto nested{
+      read.getParameter<std::vector<std::vector<Parameters>>>("nested")};
+  REQUIRE(nested.size() == 1);
+  REQUIRE(nested[0].size() == 1);
+  CHECK(nested[0][0].getParameter<double>("threshold") == 2.5);
+
+  std::string cache_file{"config_cache_test.bin"};
+  framework::config::writeCache(cache_file, 42, config);
+  Parameters cached;
+  CHECK_FALSE(framework::config::readCache(cache_file, 43, cached));
+  REQUIRE(framework::config::readCache(cache_file, 42, cached));
+  CHECK(cached.getParameter<int>("maxEvents") == 10);
+  std::remove(cache_file.c_str());
+}
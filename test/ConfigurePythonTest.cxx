@@ -46,6 +46,7 @@ class TestConfig : public framework::Producer {
    * - vector of ints parameter
    * - vector of doubles parameter
    * - vector of strings parameter
+   * - arrays given through the buffer protocol
    */
   void configure(framework::config::Parameters &parameters) final override {
     // Check parameters
@@ -95,6 +96,18 @@ class TestConfig : public framework::Producer {
         CHECK(test_2d_vec.at(i).at(j) == twod_vec.at(i).at(j));
       }
     }
+
+    // check arrays, read in place and converted
+    const auto &test_double_array{
+        parameters.getParameterRef<std::vector<double>>("test_double_array")};
+    CHECK(test_double_array == std::vector<double>{0.5, 1.5, 2.5});
+    CHECK(parameters.getParameter<std::vector<int>>("test_int_array") ==
+          std::vector<int>{4, 5, 6});
+    CHECK(parameters.getParameter<std::vector<int>>("test_long_array") ==
+          std::vector<int>{-7, 8, 9});
+    CHECK(parameters.getParameter<std::vector<std::vector<int>>>(
+              "test_2d_array") == std::vector<std::vector<int>>{{1, 2, 3},
+                                                                {4, 5, 6}});
   }
 
   // I don't do anything.
@@ -123,6 +136,7 @@ DECLARE_PRODUCER_NS(framework::test, TestConfig)
  * - pass parameters to Process object
  * - pass parameters to EventProcessors
  * - use arguments to python script on command line
+ * - reject integer arrays with items out of the range of an int
  * - TODO pass histogram info to EventProcessors
  * - TODO pass class objects to EventProcessors
  */
@@ -191,4 +205,23 @@ TEST_CASE("Configure Python Test", "[Framework][functionality]") {
     // because we left during an exception without closing it above
     Py_FinalizeEx();
   }
+
+  // add an array with an integer too large for an int
+  in_file.open(config_file_name.c_str(), std::ios::in | std::ios::binary);
+
+  out_file.open(config_file_name_arg, std::ios::out | std::ios::binary);
+  out_file << in_file.rdbuf();
+  out_file << "p.sequence[0].too_large = array.array('q', [ 1 , 2**40 ])"
+           << std::endl;
+
+  in_file.close();
+  out_file.close();
+
+  SECTION("Array overflow exception test") {
+    REQUIRE_THROWS_WITH(
+        std::make_unique<framework::ConfigurePython>(config_file_name_arg, args,
+                                                     0),
+        ContainsSubstring("'too_large' has an item 1099511627776"));
+    Py_FinalizeEx();
+  }
 }
@@ -1,6 +1,7 @@
 #include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers.hpp>
+#include <atomic>
 #include <cstdio>  //for remove
 
 #include "Framework/EventFile.h"
@@ -9,6 +10,7 @@
 #include "Framework/RunHeader.h"
 #include "Hcal/Event/HcalHit.h"
 #include "Hcal/Event/HcalVetoResult.h"
+#include "RVersion.h"  //to check if RNTuple is available
 #include "Recon/Event/CalorimeterHit.h"
 #include "TFile.h"        //to open and check root files
 #include "TH1F.h"         //for test histogram
@@ -36,7 +38,8 @@ namespace test {
  * - Event::add function does not throw any errors.
  * - Writes and adds a run header where the run number and the number of events
  * are the same.
- * - sets a storage hint
+ * - sets a storage hint (and a must drop hint for odd events if dropOdd)
+ * - aborts the event with the number abortEvent, if given
  */
 class TestProducer : public Producer {
   /// number of events we've gotten to
@@ -45,12 +48,20 @@ class TestProducer : public Producer {
   /// should we create the run header?
   bool createRunHeader_;
 
+  /// should we say odd indexed events must be dropped?
+  bool dropOdd_;
+
+  /// event number to abort, zero for none
+  int abortEvent_;
+
  public:
   TestProducer(const std::string& name, Process& p) : Producer(name, p) {}
   ~TestProducer() {}
 
   void configure(framework::config::Parameters& p) final override {
     createRunHeader_ = p.getParameter<bool>("createRunHeader");
+    dropOdd_ = p.getParameter<bool>("dropOdd", false);
+    abortEvent_ = p.getParameter<int>("abortEvent", 0);
   }
 
   void beforeNewRun(ldmx::RunHeader& header) final override {
@@ -64,6 +75,8 @@ class TestProducer : public Producer {
 
     REQUIRE(i_event > 0);
 
+    if (i_event == abortEvent_) abortEvent();
+
     std::vector<ldmx::CalorimeterHit> caloHits;
     for (int i = 0; i < i_event; i++) {
       caloHits.emplace_back();
@@ -89,7 +102,10 @@ class TestProducer : public Producer {
     float test_float = i_event * 0.1;
     REQUIRE_NOTHROW(event.add("EventTenth", test_float));
 
-    if (res.passesVeto()) setStorageHint(StorageControl::Hint::MustKeep);
+    if (res.passesVeto())
+      setStorageHint(StorageControl::Hint::MustKeep);
+    else if (dropOdd_)
+      setStorageHint(StorageControl::Hint::MustDrop);
 
     return;
   }
@@ -103,6 +119,8 @@ class TestProducer : public Producer {
  * - the correct number and contents following the pattern produced by
  * TestProducer.
  * - Event::getCollection and Event::getObject don't throw errors.
+ * - Event::getObject keeps throwing for a missing product
+ * - the tasks of a parallelFor see the header of the event being analyzed
  */
 class TestAnalyzer : public Analyzer {
  public:
@@ -140,6 +158,10 @@ class TestAnalyzer : public Analyzer {
     const float& tenth_event = event.getObject<float>("EventTenth");
     CHECK(tenth_event == Approx(i_event * 0.1));
 
+    // a missing product is reported every time it is asked for
+    CHECK_THROWS(event.getObject<float>("NotThere", "test"));
+    CHECK_THROWS(event.getObject<float>("NotThere", "test"));
+
     const std::vector<int>& i_event_from_bus =
         event.getCollection<int>("EventIndex");
 
@@ -147,6 +169,13 @@ class TestAnalyzer : public Analyzer {
     CHECK(i_event_from_bus.at(0) == i_event);
     CHECK(i_event_from_bus.at(1) == i_event);
 
+    // Catch2 isn't thread safe, so we only count in the tasks
+    std::atomic<int> wrong_headers{0};
+    parallelFor(0, 4, [&](std::size_t) {
+      if (getEventHeader().getEventNumber() != i_event) wrong_headers++;
+    });
+    CHECK(wrong_headers == 0);
+
     return;
   }
 
@@ -389,6 +418,21 @@ static bool removeFile(const std::string& filepath) {
   return remove(filepath.c_str()) == 0;
 }
 
+/**
+ * @func eventNumbers
+ * Get the numbers of the events in the file, in the order they are stored
+ */
+static std::vector<int> eventNumbers(const std::string& filepath) {
+  std::vector<int> numbers;
+  TFile* f = TFile::Open(filepath.c_str());
+  if (!f) return numbers;
+  TTreeReader events("LDMX_Events", f);
+  TTreeReaderValue<ldmx::EventHeader> header(events, "EventHeader");
+  while (events.Next()) numbers.push_back(header->getEventNumber());
+  f->Close();
+  return numbers;
+}
+
 /**
  * @func run the process for the input parameters
  */
@@ -447,6 +491,11 @@ DECLARE_ANALYZER_NS(framework::test, TestAnalyzer)
  *  - writing and reading run headers
  *  - drop/keep rules for event bus passengers
  *  - skimming events (only keeping events meeting a certain criteria)
+ *  - running the sequence in a pipeline, in order and with aborted events
+ *  - writing events into an RNTuple and reading them back
+ *  - splitting the input files between worker processes and merging them
+ *  - output streams with their own skimming and drop/keep rules
+ *  - skipping output only processors for events every output rejects
  */
 TEST_CASE("Core Framework Functionality", "[Framework][functionality]") {
   // these parameters aren't tested/changed, so we set them out here
@@ -563,6 +612,68 @@ TEST_CASE("Core Framework Functionality", "[Framework][functionality]") {
       CHECK(framework::test::removeFile(hist_file_path));
     }
 
+    SECTION("in a pipeline") {
+      std::string hist_file_path = "test_productionmode_pipeline_hists.root";
+      process["histogramFile"] = hist_file_path;
+      process["maxEvents"] = 10;
+      process["pipelineStages"] = std::vector<int>{1, 1};
+      process["pipelineDepth"] = 3;
+      // the analyzer splits each event over the threads with parallelFor
+      process["numThreads"] = 2;
+
+      std::vector<int> all_events = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+      SECTION("every event completes") {
+        sequence.push_back(analyzerConfig);
+        process["sequence"] = sequence;
+        REQUIRE(framework::test::runProcess(process));
+        CHECK_THAT(outputFiles.at(0),
+                   framework::test::isGoodEventFile("test", 10, 1));
+        CHECK(framework::test::eventNumbers(outputFiles.at(0)) == all_events);
+        CHECK_THAT(hist_file_path,
+                   framework::test::isGoodHistogramFile(1 + 2 + 3 + 4 + 5 +
+                                                        6 + 7 + 8 + 9 + 10));
+      }
+
+      SECTION("an aborted event skips the later stages") {
+        producerParameters["abortEvent"] = 4;
+        producerConfig.setParameters(producerParameters);
+        sequence = {producerConfig, analyzerConfig};
+        process["sequence"] = sequence;
+        REQUIRE(framework::test::runProcess(process));
+        CHECK_THAT(outputFiles.at(0),
+                   framework::test::isGoodEventFile("test", 9, 1));
+        all_events.erase(all_events.begin() + 3);
+        CHECK(framework::test::eventNumbers(outputFiles.at(0)) == all_events);
+        CHECK_THAT(hist_file_path,
+                   framework::test::isGoodHistogramFile(1 + 2 + 3 + 5 + 6 +
+                                                        7 + 8 + 9 + 10));
+      }
+
+      CHECK(framework::test::removeFile(hist_file_path));
+    }
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 34, 0)
+    SECTION("RNTuple storage backend") {
+      process["storageBackend"] = std::string("RNTuple");
+      REQUIRE(framework::test::runProcess(process));
+
+      // read the events back from the RNTuple
+      std::string hist_file_path = "test_productionmode_rntuple_hists.root";
+      auto readBack = process;
+      readBack["passName"] = std::string("readBack");
+      readBack["inputFiles"] = outputFiles;
+      readBack["outputFiles"] = std::vector<std::string>();
+      readBack["histogramFile"] = hist_file_path;
+      readBack["sequence"] = std::vector<framework::config::Parameters>{
+          analyzerConfig};
+      REQUIRE(framework::test::runProcess(readBack));
+      CHECK_THAT(hist_file_path,
+                 framework::test::isGoodHistogramFile(1 + 2 + 3));
+      CHECK(framework::test::removeFile(hist_file_path));
+    }
+#endif
+
     CHECK(framework::test::removeFile(outputFiles.at(0)));
   }  // Production Mode
 
@@ -697,6 +808,159 @@ TEST_CASE("Core Framework Functionality", "[Framework][functionality]") {
 
     }  // Merge Mode
 
+    SECTION("Output Streams") {
+      // one input file, no output file, two output streams
+
+      std::vector<std::string> inputFile = {inputFiles.at(2)};
+      process["inputFiles"] = inputFile;
+
+      producerParameters["createRunHeader"] = false;
+      producerParameters["dropOdd"] = true;
+      producerConfig.setParameters(producerParameters);
+      auto outputOnlyAnalyzer{analyzerParameters};
+      outputOnlyAnalyzer["outputOnly"] = true;
+      analyzerConfig.setParameters(outputOnlyAnalyzer);
+      sequence = {producerConfig, analyzerConfig};
+      process["sequence"] = sequence;
+
+      std::string hist_file_path = "test_outputstreams_hists.root";
+      process["histogramFile"] = hist_file_path;
+
+      // the process itself only keeps even indexed events
+      process["skimDefaultIsKeep"] = false;
+      std::vector<std::string> rules = {"TestProducer", ""};
+      process["skimRules"] = rules;
+      process["earlyReject"] = true;
+
+      std::string even_file_path = "test_outputstreams_even.root";
+      framework::config::Parameters even;
+      even.setParameters({{"name", std::string("even")},
+                          {"outputFile", even_file_path},
+                          {"skimDefaultIsKeep", false},
+                          {"skimRules", rules}});
+
+      std::string all_file_path = "test_outputstreams_all.root";
+      std::vector<std::string> drop = {"drop .*Collection.*"};
+      std::map<std::string, std::any> allParameters = {
+          {"name", std::string("all")},
+          {"outputFile", all_file_path},
+          {"keep", drop}};
+
+      SECTION("different skimming and drop/keep rules") {
+        framework::config::Parameters all;
+        all.setParameters(allParameters);
+        process["outputStreams"] = std::vector<framework::config::Parameters>{
+            even, all};
+        REQUIRE(framework::test::runProcess(process));
+        CHECK_THAT(even_file_path,
+                   framework::test::isGoodEventFile("test", 2, 1));
+        CHECK_THAT(all_file_path,
+                   framework::test::isGoodEventFile("test", 4, 1, false));
+        // one stream keeps every event, so the analyzer always runs
+        CHECK_THAT(hist_file_path,
+                   framework::test::isGoodHistogramFile(1 + 2 + 3 + 4));
+      }
+
+      SECTION("every stream rejects the odd events") {
+        allParameters["skimDefaultIsKeep"] = false;
+        allParameters["skimRules"] = rules;
+        framework::config::Parameters all;
+        all.setParameters(allParameters);
+        process["outputStreams"] = std::vector<framework::config::Parameters>{
+            even, all};
+        REQUIRE(framework::test::runProcess(process));
+        CHECK_THAT(even_file_path,
+                   framework::test::isGoodEventFile("test", 2, 1));
+        CHECK_THAT(all_file_path,
+                   framework::test::isGoodEventFile("test", 2, 1, false));
+        // the output only analyzer is skipped for the odd events
+        CHECK_THAT(hist_file_path, framework::test::isGoodHistogramFile(2 + 4));
+      }
+
+      CHECK(framework::test::removeFile(even_file_path));
+      CHECK(framework::test::removeFile(all_file_path));
+      CHECK(framework::test::removeFile(hist_file_path));
+    }  // Output Streams
+
+    SECTION("Worker Processes") {
+      // two input files split between two workers, merged into one file
+
+      std::vector<std::string> twoFiles = {inputFiles.at(0), inputFiles.at(1)};
+      process["inputFiles"] = twoFiles;
+      process["numWorkers"] = 2;
+
+      std::string event_file_path = "test_workers_events.root";
+      outputFiles = {event_file_path};
+      process["outputFiles"] = outputFiles;
+      std::string hist_file_path = "test_workers_hists.root";
+      process["histogramFile"] = hist_file_path;
+
+      sequence = {analyzerConfig};
+      process["sequence"] = sequence;
+
+      SECTION("every event") {
+        REQUIRE(framework::test::runProcess(process));
+        CHECK_THAT(event_file_path,
+                   framework::test::isGoodEventFile("makeInputs", 2 + 3, 2));
+        std::vector<int> events = {1, 2, 1, 2, 3};
+        CHECK(framework::test::eventNumbers(event_file_path) == events);
+        CHECK_THAT(hist_file_path,
+                   framework::test::isGoodHistogramFile(1 + 2 + 1 + 2 + 3));
+      }
+
+      SECTION("maxEvents counts the events of both workers") {
+        process["maxEvents"] = 3;
+        REQUIRE(framework::test::runProcess(process));
+        CHECK_THAT(event_file_path,
+                   framework::test::isGoodEventFile("makeInputs", 3, 2));
+        std::vector<int> events = {1, 2, 1};
+        CHECK(framework::test::eventNumbers(event_file_path) == events);
+        CHECK_THAT(hist_file_path,
+                   framework::test::isGoodHistogramFile(1 + 2 + 1));
+      }
+
+      SECTION("maxEvents within the first file") {
+        process["maxEvents"] = 1;
+        REQUIRE(framework::test::runProcess(process));
+        CHECK_THAT(event_file_path,
+                   framework::test::isGoodEventFile("makeInputs", 1, 1));
+        std::vector<int> events = {1};
+        CHECK(framework::test::eventNumbers(event_file_path) == events);
+        CHECK_THAT(hist_file_path, framework::test::isGoodHistogramFile(1));
+      }
+
+      CHECK(framework::test::removeFile(event_file_path));
+      CHECK(framework::test::removeFile(hist_file_path));
+    }  // Worker Processes
+
+    SECTION("Failing Worker Process") {
+      // the second worker can't open its input file
+
+      std::vector<std::string> badFiles = {inputFiles.at(0),
+                                           "test_workers_missing.root"};
+      process["inputFiles"] = badFiles;
+      process["numWorkers"] = 2;
+
+      std::string event_file_path = "test_failingworker_events.root";
+      outputFiles = {event_file_path};
+      process["outputFiles"] = outputFiles;
+      std::string hist_file_path = "test_failingworker_hists.root";
+      process["histogramFile"] = hist_file_path;
+
+      sequence = {analyzerConfig};
+      process["sequence"] = sequence;
+
+      CHECK_THROWS(framework::test::runProcess(process));
+      // neither the merged file nor what the other worker wrote is left
+      CHECK_FALSE(framework::test::removeFile(event_file_path));
+      CHECK_FALSE(framework::test::removeFile(
+          "test_failingworker_events_worker0.root"));
+      CHECK_FALSE(framework::test::removeFile(
+          "test_failingworker_hists_worker0.root"));
+      // the histogram file opened before the workers started
+      CHECK(framework::test::removeFile(hist_file_path));
+    }  // Failing Worker Process
+
   }  // need input files
 
 }  // process test
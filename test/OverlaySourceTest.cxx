@@ -0,0 +1,145 @@
+/**
+ * @file OverlaySourceTest.cxx
+ * @brief Test the pools of secondary events read by the OverlaySource
+ */
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Framework/OverlaySource.h"
+#include "Framework/RunHeader.h"
+#include "TFile.h"
+#include "TTree.h"
+
+namespace framework {
+namespace test {
+
+/**
+ * Write a small file of secondary events
+ *
+ * Each event only holds its own entry number, so we can tell which
+ * events of the file ended up in the pools.
+ *
+ * @param[in] fileName name of the file to write
+ * @param[in] entries number of events to write
+ */
+static void writeOverlayFile(const std::string& fileName, int entries) {
+  TFile file(fileName.c_str(), "RECREATE");
+  TTree events("LDMX_Events", "LDMX Events");
+  int index;
+  events.Branch("Index_overlay", &index);
+  for (index = 0; index < entries; index++) events.Fill();
+  TTree runs("LDMX_Run", "LDMX Run Headers");
+  ldmx::RunHeader header(1);
+  runs.Branch("RunHeader", &header);
+  runs.Fill();
+  file.Write();
+  file.Close();
+}
+
+/**
+ * Sample the secondary events for one primary event
+ *
+ * @param[in] overlay source to sample from
+ * @param[in] n number of secondary events to sample
+ * @returns entry numbers of the sampled events
+ */
+static std::vector<int> sampleEntries(OverlaySource& overlay, std::size_t n) {
+  overlay.sample(n);
+  std::vector<int> entries;
+  for (std::size_t i{0}; i < overlay.getNumSampled(); i++)
+    entries.push_back(overlay.get<int>(i, "Index_overlay"));
+  return entries;
+}
+
+/**
+ * Get the entry numbers a pool is expected to hold
+ *
+ * @param[in] start entry number of the first event in the pool
+ * @param[in] size number of events in the pool
+ * @param[in] n number of events in the file, reading loops back to the start
+ * @returns entry numbers of the events in the pool
+ */
+static std::set<int> pool(int start, int size, int n) {
+  std::set<int> entries;
+  for (int i{0}; i < size; i++) entries.insert((start + i) % n);
+  return entries;
+}
+
+}  // namespace test
+}  // namespace framework
+
+/**
+ * Test for the OverlaySource
+ *
+ * The overlay file has ten events and we sample from pools of three,
+ * moving on to the next pool every two primary events. With this many
+ * samples for each primary event, each pool is drawn from completely,
+ * so the events we see are exactly the ones in the active pool.
+ */
+TEST_CASE("Overlay Source", "[Framework][functionality]") {
+  using framework::test::pool;
+  using framework::test::sampleEntries;
+
+  const std::string file_name{"overlay_source_test.root"};
+  const int entries{10}, pool_size{3}, events_per_pool{2};
+  const std::size_t n_sampled{100};
+  framework::test::writeOverlayFile(file_name, entries);
+
+  framework::config::Parameters params;
+  params.setParameters({{"tree_name", std::string("LDMX_Events")}});
+
+  auto overlay_ptr{std::make_unique<framework::OverlaySource>(
+      params, file_name, pool_size, events_per_pool)};
+  auto& overlay{*overlay_ptr};
+  overlay.addCollection<int>("Index_overlay");
+  overlay.setSeed(42);
+
+  SECTION("Samples stay inside the active pool") {
+    // the first pool starts at a random event
+    std::set<int> seen;
+    for (int i{0}; i < events_per_pool; i++) {
+      auto sampled{sampleEntries(overlay, n_sampled)};
+      CHECK(sampled.size() == n_sampled);
+      seen.insert(sampled.begin(), sampled.end());
+    }
+    int start{-1};
+    for (int s{0}; s < entries; s++)
+      if (seen == pool(s, pool_size, entries)) start = s;
+    REQUIRE(start >= 0);
+
+    // the pools swap after each events_per_pool primary events and
+    // continue with the next events, looping around the end of the file
+    for (int i_pool{1}; i_pool < 5; i_pool++) {
+      seen.clear();
+      for (int i{0}; i < events_per_pool; i++) {
+        auto sampled{sampleEntries(overlay, n_sampled)};
+        seen.insert(sampled.begin(), sampled.end());
+      }
+      CHECK(seen == pool(start + i_pool * pool_size, pool_size, entries));
+    }
+  }
+
+  SECTION("Only added collections can be read") {
+    overlay.sample(1);
+    CHECK_THROWS(overlay.get<int>(0, "NotAdded_overlay"));
+    CHECK_THROWS(overlay.addCollection<int>("NotAdded_overlay"));
+  }
+
+  SECTION("Same seed reproduces the same events") {
+    framework::OverlaySource again(params, file_name, pool_size,
+                                   events_per_pool);
+    again.addCollection<int>("Index_overlay");
+    again.setSeed(42);
+    for (int i{0}; i < 3 * events_per_pool; i++)
+      CHECK(sampleEntries(overlay, 5) == sampleEntries(again, 5));
+  }
+
+  // close the file before removing it
+  overlay_ptr.reset();
+  std::remove(file_name.c_str());
+}
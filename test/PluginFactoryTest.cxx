@@ -0,0 +1,105 @@
+/**
+ * @file PluginFactoryTest.cxx
+ * @brief Test loading libraries lazily through the plugin index
+ */
+#include <catch2/catch_test_macros.hpp>
+
+#include <dlfcn.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "Framework/PluginFactory.h"
+#include "Framework/Process.h"
+
+namespace framework {
+namespace test {
+
+/**
+ * Get the directory the Framework library was loaded from
+ *
+ * The test plugin library is built into the same directory.
+ *
+ * @returns path to directory holding the Framework library
+ */
+static std::filesystem::path frameworkDirectory() {
+  Dl_info info;
+  REQUIRE(dladdr(reinterpret_cast<void*>(&PluginFactory::getInstance),
+                 &info) != 0);
+  return std::filesystem::absolute(info.dli_fname).parent_path();
+}
+
+/**
+ * Read the class to library pairs in an index
+ *
+ * @param[in] indexFile index to read
+ * @returns map of class names to libraries
+ */
+static std::map<std::string, std::string> readEntries(
+    const std::string& indexFile) {
+  std::map<std::string, std::string> entries;
+  std::ifstream index(indexFile);
+  std::string classname, libname;
+  while (index >> classname >> libname) entries[classname] = libname;
+  return entries;
+}
+
+}  // namespace test
+}  // namespace framework
+
+/**
+ * Test for the plugin index of the PluginFactory
+ *
+ * The test plugin library registers a single producer. It is only
+ * listed in the index at first, so the producer is unknown until it
+ * is created and its library is loaded. Once loaded, writing the index
+ * lists the library, and paths to the same library are recognized even
+ * if they are spelled differently.
+ *
+ * The factory is shared by the whole test executable, so this is one
+ * sequence of checks rather than independent sections.
+ */
+TEST_CASE("Plugin Index", "[Framework][functionality]") {
+  auto& factory{framework::PluginFactory::getInstance()};
+  auto process{framework::Process::getDummy()};
+
+  const std::string classname{"framework::test::IndexedProducer"};
+  const std::string index_file{"plugin_factory_test.index"};
+  auto directory{framework::test::frameworkDirectory()};
+  auto plugin{(directory / "libFrameworkTestPlugin.so").string()};
+  REQUIRE(std::filesystem::exists(plugin));
+
+  // only put the library in the index, don't load it
+  {
+    std::ofstream index(index_file);
+    index << classname << " " << plugin << "\n";
+  }
+  REQUIRE(factory.readIndex(index_file));
+  CHECK_FALSE(factory.readIndex("plugin_factory_test_missing.index"));
+  CHECK(factory.isIndexed(plugin));
+  CHECK(factory.isIndexed((directory / "." / "libFrameworkTestPlugin.so")
+                              .string()));
+  CHECK_FALSE(factory.isIndexed("libFrameworkNotIndexed.so"));
+  CHECK(factory.getEventProcessorClasstype(classname) == 0);
+
+  // creating the producer loads its library
+  std::unique_ptr<framework::EventProcessor> producer{
+      factory.createEventProcessor(classname, "indexed", process)};
+  REQUIRE(producer);
+  CHECK(factory.getEventProcessorClasstype(classname) ==
+        framework::Producer::CLASSTYPE);
+
+  // the library it was registered from is written to the index
+  factory.writeIndex(index_file);
+  auto entries{framework::test::readEntries(index_file)};
+  REQUIRE(entries.count(classname) == 1);
+  CHECK(std::filesystem::equivalent(entries.at(classname), plugin));
+  REQUIRE(factory.readIndex(index_file));
+  CHECK(factory.isIndexed(entries.at(classname)));
+
+  std::remove(index_file.c_str());
+}
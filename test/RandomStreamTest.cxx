@@ -0,0 +1,62 @@
+/**
+ * @file RandomStreamTest.cxx
+ * @brief Test the counter-based random streams
+ */
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+
+#include "Framework/RandomStream.h"
+
+using framework::RandomStream;
+
+/**
+ * Test for RandomStream
+ *
+ * The Philox4x32-10 blocks need to match the known-answer tests published
+ * with the algorithm (Random123 kat_vectors), otherwise our numbers would
+ * differ from every other implementation. We also check that a stream can
+ * be recreated in the middle of a job and that streams with different
+ * counters are different.
+ */
+TEST_CASE("Philox random streams", "[Framework][functionality]") {
+  SECTION("Known answers") {
+    CHECK(RandomStream::philox({0, 0, 0, 0}, {0, 0}) ==
+          RandomStream::Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c,
+                                0x9b00dbd8});
+    CHECK(RandomStream::philox(
+              {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+              {0xffffffff, 0xffffffff}) ==
+          RandomStream::Counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6,
+                                0x6d5451fd});
+    CHECK(RandomStream::philox(
+              {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+              {0xa4093822, 0x299f31d0}) ==
+          RandomStream::Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420,
+                                0x24126ea1});
+  }
+
+  SECTION("Streams are reproducible") {
+    RandomStream a(42, 7, 1), b(42, 7, 1);
+    std::vector<uint32_t> first(10);
+    for (auto &x : first) x = a();
+    for (auto x : first) CHECK(b() == x);
+    // the first block is the block of counter zero
+    CHECK(first[0] == RandomStream::philox({0, 0, 7, 1}, {42, 0})[0]);
+  }
+
+  SECTION("Different events get different streams") {
+    RandomStream a(42, 7, 1), b(42, 8, 1), c(43, 7, 1);
+    CHECK(a() != b());
+    CHECK(a() != c());
+  }
+
+  SECTION("Uniform numbers are in [0,1)") {
+    RandomStream a(1, 2, 3);
+    for (int i{0}; i < 1000; i++) {
+      double u{a.uniform()};
+      CHECK(u >= 0.);
+      CHECK(u < 1.);
+    }
+  }
+}
@@ -0,0 +1,93 @@
+/**
+ * @file ScheduleTest.cxx
+ * @brief Test grouping the processors into levels run concurrently
+ */
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Framework/EventProcessor.h"
+#include "Framework/Process.h"
+
+namespace framework {
+namespace test {
+
+/**
+ * A producer which only declares what it consumes and produces
+ */
+class LevelProducer : public Producer {
+ public:
+  LevelProducer(const std::string& name, Process& p,
+                const std::vector<std::string>& consumes,
+                const std::vector<std::string>& produces)
+      : Producer(name, p) {
+    for (const auto& c : consumes) this->consumes(c);
+    for (const auto& c : produces) this->produces(c);
+  }
+  void produce(Event&) final override {}
+};
+
+}  // namespace test
+}  // namespace framework
+
+/**
+ * Test for Process::makeLevels
+ *
+ * We check that consumers come after the producers of their collections,
+ * that producers of a collection come after its earlier consumers and
+ * producers, that independent processors share a level, and that
+ * processors which don't declare anything separate everything before
+ * them from everything after them.
+ */
+TEST_CASE("Processor Levels", "[Framework][functionality]") {
+  using framework::test::LevelProducer;
+  using Levels = std::vector<std::vector<std::size_t>>;
+  auto process{framework::Process::getDummy()};
+
+  std::vector<std::unique_ptr<LevelProducer>> owned;
+  auto add = [&](const std::vector<std::string>& consumes,
+                 const std::vector<std::string>& produces) {
+    owned.push_back(std::make_unique<LevelProducer>(
+        "p" + std::to_string(owned.size()), process, consumes, produces));
+  };
+  auto levels = [&]() {
+    std::vector<framework::EventProcessor*> sequence;
+    for (auto& p : owned) sequence.push_back(p.get());
+    return framework::Process::makeLevels(sequence);
+  };
+
+  SECTION("Independent processors share a level") {
+    add({}, {"A"});
+    add({}, {"B"});
+    add({"C"}, {"D"});
+    CHECK(levels() == Levels{{0, 1, 2}});
+  }
+
+  SECTION("Consumers come after producers") {
+    add({}, {"A"});
+    add({"A"}, {"B"});
+    add({"B"}, {"C"});
+    add({"A"}, {"E"});
+    CHECK(levels() == Levels{{0}, {1, 3}, {2}});
+  }
+
+  SECTION("Producers come after earlier consumers and producers") {
+    add({"A"}, {"B"});
+    add({}, {"A"});
+    add({}, {"B"});
+    CHECK(levels() == Levels{{0}, {1, 2}});
+  }
+
+  SECTION("Undeclared processors depend on everything") {
+    add({}, {"A"});
+    add({}, {"B"});
+    add({}, {});
+    add({}, {"C"});
+    add({}, {"D"});
+    CHECK(levels() == Levels{{0, 1}, {2}, {3, 4}});
+  }
+
+  SECTION("Empty sequence") { CHECK(levels().empty()); }
+}
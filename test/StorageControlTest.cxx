@@ -0,0 +1,88 @@
+/**
+ * @file StorageControlTest.cxx
+ * @brief Test the decisions made by the StorageControl
+ */
+#include <catch2/catch_test_macros.hpp>
+
+#include "Framework/StorageControl.h"
+
+using framework::StorageControl;
+
+/**
+ * Test for StorageControl
+ *
+ * We check that only hints from processors (and purposes) matching
+ * one of the listening rules are counted and that the decision follows
+ * the documented priority of the hints. The same processor and purpose
+ * give the same hints more than once to check the cached decisions.
+ */
+TEST_CASE("Storage Control Decisions", "[Framework][functionality]") {
+  StorageControl sc;
+  sc.setDefaultKeep(false);
+  sc.addRule("skim.*", "");
+  sc.addRule("veto", "trigger");
+
+  SECTION("Incomplete events are not kept") {
+    sc.addHint("skimmer", StorageControl::Hint::MustKeep, "");
+    CHECK_FALSE(sc.keepEvent(false));
+  }
+
+  SECTION("Default with no hints") {
+    CHECK_FALSE(sc.keepEvent(true));
+    sc.setDefaultKeep(true);
+    CHECK(sc.keepEvent(true));
+  }
+
+  SECTION("Hints we are not listening to are ignored") {
+    sc.addHint("other", StorageControl::Hint::MustKeep, "");
+    sc.addHint("veto", StorageControl::Hint::MustKeep, "physics");
+    sc.addHint("veto", StorageControl::Hint::MustKeep, "physics");
+    CHECK_FALSE(sc.keepEvent(true));
+    sc.addHint("veto", StorageControl::Hint::ShouldKeep, "trigger");
+    CHECK(sc.keepEvent(true));
+  }
+
+  SECTION("Simple majority of votes") {
+    sc.addHint("skimA", StorageControl::Hint::ShouldKeep, "");
+    sc.addHint("skimB", StorageControl::Hint::ShouldKeep, "any");
+    sc.addHint("skimA", StorageControl::Hint::ShouldDrop, "");
+    CHECK(sc.keepEvent(true));
+    sc.addHint("skimB", StorageControl::Hint::ShouldDrop, "any");
+    CHECK_FALSE(sc.keepEvent(true));
+    sc.addHint("skimA", StorageControl::Hint::ShouldDrop, "");
+    CHECK_FALSE(sc.keepEvent(true));
+  }
+
+  SECTION("Must hints take priority") {
+    sc.addHint("skimA", StorageControl::Hint::ShouldDrop, "");
+    sc.addHint("skimA", StorageControl::Hint::MustKeep, "");
+    CHECK(sc.keepEvent(true));
+    sc.addHint("skimA", StorageControl::Hint::MustDrop, "");
+    CHECK_FALSE(sc.keepEvent(true));
+  }
+
+  SECTION("Events are only rejected early by must drop") {
+    sc.addHint("skimA", StorageControl::Hint::ShouldDrop, "");
+    sc.addHint("other", StorageControl::Hint::MustDrop, "");
+    CHECK_FALSE(sc.isRejected());
+    sc.addHint("skimA", StorageControl::Hint::MustDrop, "");
+    CHECK(sc.isRejected());
+    sc.resetEventState();
+    CHECK_FALSE(sc.isRejected());
+  }
+
+  SECTION("State is reset between events") {
+    sc.addHint("skimA", StorageControl::Hint::MustKeep, "");
+    CHECK(sc.keepEvent(true));
+    sc.resetEventState();
+    CHECK_FALSE(sc.keepEvent(true));
+  }
+
+  SECTION("New rules are used for processors we already heard from") {
+    sc.addHint("other", StorageControl::Hint::ShouldKeep, "");
+    CHECK_FALSE(sc.keepEvent(true));
+    sc.addRule("other", "");
+    sc.addHint("other", StorageControl::Hint::ShouldKeep, "");
+    CHECK(sc.keepEvent(true));
+  }
+}
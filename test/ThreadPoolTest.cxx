@@ -0,0 +1,66 @@
+/**
+ * @file ThreadPoolTest.cxx
+ * @brief Test the threads shared by the processors
+ */
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "Framework/ThreadPool.h"
+
+using framework::ThreadPool;
+
+/**
+ * Test for ThreadPool
+ *
+ * We check that every task of a group and every index of a parallel
+ * loop is run exactly once, that loops can be nested inside of tasks
+ * (which is what happens when a processor running on the pool uses
+ * parallelFor), and that errors are passed back to the waiting thread.
+ */
+TEST_CASE("Thread Pool Tasks", "[Framework][functionality]") {
+  ThreadPool pool(3);
+  CHECK(pool.concurrency() == 4);
+
+  SECTION("Every task in a group is run") {
+    std::atomic<int> count{0};
+    ThreadPool::TaskGroup group(pool);
+    for (int i{0}; i < 100; i++) group.run([&count]() { count++; });
+    group.wait();
+    CHECK(count == 100);
+  }
+
+  SECTION("Every index of a loop is visited once") {
+    std::vector<int> visits(1000, 0);
+    pool.parallelFor(0, visits.size(), [&](std::size_t i) { visits[i]++; });
+    for (int v : visits) CHECK(v == 1);
+  }
+
+  SECTION("Loops nested in tasks") {
+    std::vector<std::vector<int>> visits(8, std::vector<int>(50, 0));
+    ThreadPool::TaskGroup group(pool);
+    for (auto &inner : visits) {
+      group.run([&pool, &inner]() {
+        pool.parallelFor(0, inner.size(), [&](std::size_t i) { inner[i]++; });
+      });
+    }
+    group.wait();
+    for (const auto &inner : visits)
+      for (int v : inner) CHECK(v == 1);
+  }
+
+  SECTION("Errors are passed to the waiting thread") {
+    CHECK_THROWS_AS(pool.parallelFor(0, 10,
+                                     [](std::size_t i) {
+                                       if (i == 7)
+                                         throw std::runtime_error("seven");
+                                     }),
+                    std::runtime_error);
+    // the pool is still usable afterwards
+    std::atomic<int> count{0};
+    pool.parallelFor(0, 10, [&count](std::size_t) { count++; });
+    CHECK(count == 10);
+  }
+}
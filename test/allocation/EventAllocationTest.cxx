@@ -0,0 +1,89 @@
+/**
+ * @file EventAllocationTest.cxx
+ * @brief Test that the event loop doesn't allocate once it is warmed up
+ */
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "Framework/Event.h"
+#include "Framework/StorageControl.h"
+
+namespace {
+/// is this thread counting allocations right now?
+thread_local bool counting{false};
+/// number of calls to operator new by the counting thread
+std::size_t n_allocations{0};
+
+/**
+ * Count the allocations made by this thread while in scope
+ */
+class CountAllocations {
+ public:
+  CountAllocations() { counting = true; }
+  ~CountAllocations() { counting = false; }
+};
+}  // namespace
+
+/**
+ * Count the allocations made through operator new while counting
+ *
+ * The array and nothrow versions call this one by default. This
+ * replaces the allocator of the whole program, so this test is built
+ * into an executable of its own.
+ */
+void *operator new(std::size_t size) {
+  if (counting) n_allocations++;
+  if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+/**
+ * Test for allocations in the event loop
+ *
+ * We go through the steps the framework takes for each event when
+ * producing events: adding products (with names longer than fit into
+ * a string without allocating), getting them back with and without the
+ * pass name, adding storage hints, deciding if the event is kept, and
+ * clearing the event. After a few events to warm up, none of this should
+ * allocate memory.
+ */
+TEST_CASE("Steady-state event loop allocations", "[Framework][performance]") {
+  framework::Event event("allocations");
+  framework::StorageControl storage;
+  storage.setDefaultKeep(false);
+  storage.addRule("skimmer", "");
+
+  std::vector<int> hits(100, 1);
+  int count{5};
+  bool ok{true};
+  auto one_event = [&]() {
+    storage.resetEventState();
+    event.add("SomeLongCollectionName", hits);
+    event.add("AnotherCount", count);
+    ok = ok and event.getCollection<int>("SomeLongCollectionName").size() ==
+                    hits.size();
+    ok = ok and event.getObject<int>("AnotherCount", "allocations") == count;
+    storage.addHint("skimmer", framework::StorageControl::Hint::ShouldKeep,
+                    "");
+    ok = ok and storage.keepEvent(true);
+    event.beforeFill();
+    event.Clear();
+  };
+
+  for (int i{0}; i < 3; i++) one_event();
+
+  {
+    CountAllocations scope;
+    for (int i{0}; i < 100; i++) one_event();
+  }
+
+  CHECK(ok);
+  CHECK(n_allocations == 0);
+}
@@ -1,5 +1,6 @@
 
 from LDMX.Framework import ldmxcfg
+import array
 
 class TestProcessor(ldmxcfg.Producer):
   """Configuration for the producer defined in ConfigurePythonTest.
@@ -20,6 +21,14 @@ class TestProcessor(ldmxcfg.Producer):
     List of strings test parameter.
   test_dict : dict
     Dictionary test parameter.
+  test_double_array : array.array
+    Array of doubles test parameter.
+  test_int_array : array.array
+    Array of shorts test parameter.
+  test_long_array : array.array
+    Array of 64 bit integers test parameter.
+  test_2d_array : memoryview
+    Two dimensional array of ints test parameter.
   """
   
   def __init__(self): 
@@ -33,6 +42,10 @@ class TestProcessor(ldmxcfg.Producer):
     self.test_double_vec = [ 0.1 , 0.2 , 0.3 ]
     self.test_string_vec = [ 'first' , 'second' , 'third' ]
     self.test_2dlist = [ [ 11, 12, 13], [21, 22], [31,32,33,34]]
+    self.test_double_array = array.array('d', [ 0.5 , 1.5 , 2.5 ])
+    self.test_int_array = array.array('h', [ 4 , 5 , 6 ])
+    self.test_long_array = array.array('q', [ -7 , 8 , 9 ])
+    self.test_2d_array = memoryview(array.array('i', [ 1 , 2 , 3 , 4 , 5 , 6 ])).cast('B').cast('i', [ 2 , 3 ])
 
 
 # Create a process
@@ -0,0 +1,24 @@
+/**
+ * @file IndexedProducer.cxx
+ * @brief Producer in a library of its own, loaded through the plugin index
+ */
+#include "Framework/EventProcessor.h"
+
+namespace framework {
+namespace test {
+
+/**
+ * @class IndexedProducer
+ * Producer that does nothing, it is only here to be registered once
+ * its library is loaded.
+ */
+class IndexedProducer : public Producer {
+ public:
+  IndexedProducer(const std::string& name, Process& p) : Producer(name, p) {}
+  void produce(Event&) final override {}
+};  // IndexedProducer
+
+}  // namespace test
+}  // namespace framework
+
+DECLARE_PRODUCER_NS(framework::test, IndexedProducer)